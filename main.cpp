@@ -8,381 +8,7283 @@
 #include <string>
 #include <ctime>
 #include <algorithm>
+#include <cstdint>
+#include <array>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <memory>
+#include <utility>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdio>
+#include <new>
+#include <iterator>
+#include <streambuf>
 #include <omp.h>
 
-// GameOfLife class - handles the game logic and world state
-class GameOfLife {
+#include <cstring>
+#include <cctype>
+#include <cstdlib>
+
+#ifdef __linux__
+#include <sched.h>
+#ifdef GOL_PROFILING
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#define GOL_HAVE_MMAP 1
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#endif
+
+#ifdef GOL_MPI
+#include <mpi.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GOL_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+// Contiguous band [begin, end) of 'rows' owned by thread 'thread' of 'threads'.
+// Grids are first written and evolved with the same bands, so on NUMA systems
+// each thread mostly reads and writes memory placed on its own node.
+static inline void rowBand(int rows, int thread, int threads, int& begin, int& end) {
+    begin = static_cast<int>(static_cast<int64_t>(rows) * thread / threads);
+    end = static_cast<int>(static_cast<int64_t>(rows) * (thread + 1) / threads);
+}
+
+// Allocator whose default construction leaves memory untouched, so the pages
+// of a vector are placed by whichever thread writes them first
+template<typename T>
+struct FirstTouchAllocator : std::allocator<T> {
+    template<typename U> struct rebind { typedef FirstTouchAllocator<U> other; };
+
+    FirstTouchAllocator() noexcept {}
+    template<typename U> FirstTouchAllocator(const FirstTouchAllocator<U>&) noexcept {}
+
+    template<typename U> void construct(U* p) noexcept {
+        ::new (static_cast<void*>(p)) U;
+    }
+
+    template<typename U, typename... Args> void construct(U* p, Args&&... args) {
+        ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+};
+
+// ThreadAffinity - optional pinning of the OpenMP threads to CPUs
+// Thread i of n goes to the (i * cpus / n)-th CPU the process may run on, so
+// consecutive threads (and their consecutive row bands) share a node while the
+// team still spreads over every socket.
+class ThreadAffinity {
 private:
-    int width;                  // Width of the grid
-    int height;                 // Height of the grid
-    std::vector<std::vector<bool>> current; // Current generation
-    std::vector<std::vector<bool>> next;    // Next generation
-    std::vector<std::vector<std::vector<bool>>> history; // History of previous states for stability check
+#ifdef __linux__
+    // CPUs the process was allowed to use before any pinning
+    static const cpu_set_t& processMask() {
+        static cpu_set_t mask = []() {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            sched_getaffinity(0, sizeof(set), &set);
+            return set;
+        }();
+        return mask;
+    }
+#endif
 
-    // Helper function to calculate the number of live neighbors for a cell
-    int countNeighbors(int x, int y) {
-        int count = 0;
-        for (int i = -1; i <= 1; i++) {
-            for (int j = -1; j <= 1; j++) {
-                if (i == 0 && j == 0) continue; // Skip the cell itself
-                
-                // Handle toroidal world by wrapping around edges
-                int nx = (x + i + width) % width;
-                int ny = (y + j + height) % height;
-                
-                if (current[ny][nx]) count++;
-            }
+    static bool& pinnedFlag() {
+        static bool pinned = false;
+        return pinned;
+    }
+
+public:
+    // Pin every thread of the current OpenMP team, returns false if unsupported
+    static bool pin() {
+#ifdef __linux__
+        const cpu_set_t& mask = processMask();
+        std::vector<int> cpus;
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &mask)) cpus.push_back(cpu);
         }
-        return count;
+        if (cpus.empty()) return false;
+        bool ok = true;
+        #pragma omp parallel reduction(&&:ok)
+        {
+            int thread = omp_get_thread_num();
+            int threads = omp_get_num_threads();
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpus[static_cast<size_t>(thread) * cpus.size() / threads], &set);
+            ok = sched_setaffinity(0, sizeof(set), &set) == 0;
+        }
+        pinnedFlag() = ok;
+        return ok;
+#else
+        return false;
+#endif
+    }
+
+    // Let every thread run on any CPU of the process again
+    static void unpin() {
+#ifdef __linux__
+        if (!pinnedFlag()) return;
+        const cpu_set_t& mask = processMask();
+        #pragma omp parallel
+        {
+            sched_setaffinity(0, sizeof(mask), &mask);
+        }
+#endif
+        pinnedFlag() = false;
+    }
+
+    static bool isPinned() {
+        return pinnedFlag();
     }
+};
 
+#ifdef GOL_PROFILING
+// Profiler - hot-path instrumentation, built in with GOL_PROFILING (the
+// CMake option of the same name). Phase timers and per-thread band times
+// are relaxed atomic adds of steady_clock differences; 'profile off' skips
+// the clock reads at run time, and without GOL_PROFILING the GOL_PROFILE_*
+// macros expand to nothing. Heap allocations are counted by the replaced
+// global operator new. Hardware counters (perf_event_open, Linux) are
+// opened on request, one set per OpenMP thread.
+class Profiler {
 public:
-    // Constructor for new world with given dimensions
-    GameOfLife(int w, int h) : width(w), height(h) {
-        // Initialize current and next generations
-        current.resize(height, std::vector<bool>(width, false));
-        next.resize(height, std::vector<bool>(width, false));
-        
-        // Initialize history with current state
-        history.push_back(current);
+    enum Phase { Evolve, CycleCheck, Advance, Render, Checkpoint, Record, Phases };
+    static constexpr int maxThreads = 256;
+
+    static Profiler& instance() {
+        static Profiler profiler;
+        return profiler;
     }
 
-    // Constructor for loading from file
-    GameOfLife(const std::string& filename) {
-        load(filename);
+    static std::atomic<uint64_t>& allocations() {
+        static std::atomic<uint64_t> count(0);
+        return count;
     }
 
-    // Evolve the world one generation - PARALLELIZED VERSION
-    void evolve() {
-        // Parallel loop over all cells - no dependencies between iterations
-        #pragma omp parallel for collapse(2) schedule(static)
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                int neighbors = countNeighbors(x, y);
-                bool isAlive = current[y][x];
-                
-                // Apply Conway's Game of Life rules
-                if (isAlive && (neighbors < 2 || neighbors > 3)) {
-                    next[y][x] = false; // Cell dies due to under/overpopulation
-                } else if (!isAlive && neighbors == 3) {
-                    next[y][x] = true;  // Cell is born
-                } else {
-                    next[y][x] = isAlive; // Cell remains the same
-                }
-            }
+    static uint64_t now() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    bool isEnabled() const {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    void setEnabled(bool on) {
+        enabled.store(on, std::memory_order_relaxed);
+    }
+
+    void addPhase(Phase phase, uint64_t ns) {
+        phaseNs[phase].fetch_add(ns, std::memory_order_relaxed);
+        phaseCalls[phase].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // A thread spent 'ns' on its band of one generation
+    void addBand(int thread, uint64_t ns) {
+        if (thread < maxThreads) threads[thread].busyNs.fetch_add(ns, std::memory_order_relaxed);
+    }
+
+    // A thread waited 'ns' for the rest of the team
+    void addWait(int thread, uint64_t ns) {
+        if (thread < maxThreads) threads[thread].waitNs.fetch_add(ns, std::memory_order_relaxed);
+    }
+
+    void addCells(uint64_t cells) {
+        cellsUpdated.fetch_add(cells, std::memory_order_relaxed);
+        generations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Start a measured run: clear every counter
+    void begin() {
+        for (int p = 0; p < Phases; p++) {
+            phaseNs[p] = 0;
+            phaseCalls[p] = 0;
         }
-        
-        // Update current generation with the next generation
-        current = next;
-        
-        // Add current state to history for stability checking
-        history.push_back(current);
-        
-        // Keep only the last 3 generations for stability checks
-        if (history.size() > 3) {
-            history.erase(history.begin());
+        for (ThreadTimes& t : threads) {
+            t.busyNs = 0;
+            t.waitNs = 0;
         }
+        cellsUpdated = 0;
+        generations = 0;
+        allocationsAtBegin = allocations().load(std::memory_order_relaxed);
+        readHardware(hardwareAtBegin);
+        beginNs = now();
+        endNs = 0;
     }
 
-    // Check if the world is stable (contains only still lifes or period-2 oscillators)
-    bool isStable() {
-        if (history.size() < 3) return false;
-        
-        // Check for still lifes (current equals previous)
-        if (history[1] == history[2]) {
-            return true;
-        }
-        
-        // Check for period-2 oscillators (current equals second previous)
-        if (history[0] == history[2]) {
-            return true;
+    void end() {
+        endNs = now();
+        allocationsAtEnd = allocations().load(std::memory_order_relaxed);
+        readHardware(hardwareAtEnd);
+    }
+
+    // Open (or close) the hardware counters on every thread of the current
+    // OpenMP team. Returns false if the kernel refuses them.
+    bool setHardware(bool on) {
+        closeHardware();
+        if (!on) return true;
+#ifdef __linux__
+        int team = std::min(omp_get_max_threads(), maxThreads);
+        bool ok = true;
+        #pragma omp parallel num_threads(team) reduction(&&:ok)
+        {
+            int thread = omp_get_thread_num();
+            for (int e = 0; e < hardwareEvents; e++) {
+                perf_event_attr attr;
+                std::memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = hardwareConfigs[e];
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                // pid 0, cpu -1: the calling thread on any CPU
+                int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+                threads[thread].fds[e] = fd;
+                ok = ok && fd >= 0;
+            }
         }
-        
+        hardwareThreads = team;
+        if (!ok) closeHardware();
+        return ok;
+#else
         return false;
+#endif
     }
 
-    // Print the current state of the world - PARALLELIZED VERSION
-    void print() {
-        // Pre-compute all output strings in parallel
-        std::vector<std::string> lines(height);
-        
-        #pragma omp parallel for schedule(static)
-        for (int y = 0; y < height; y++) {
-            std::string line;
-            line.reserve(width * 2); // Reserve space for efficiency
-            for (int x = 0; x < width; x++) {
-                line += (current[y][x] ? "■ " : "□ ");
-            }
-            lines[y] = line;
+    bool hasHardware() const {
+        return hardwareThreads > 0;
+    }
+
+    void print(std::ostream& out) const {
+        if (beginNs == 0) {
+            out << "Profile: no run measured yet" << std::endl;
+            return;
         }
-        
-        // Sequential output to maintain order
-        for (int y = 0; y < height; y++) {
-            std::cout << lines[y] << std::endl;
+        double wallMs = static_cast<double>((endNs ? endNs : now()) - beginNs) / 1e6;
+        out << "Profile of the last run (" << generations.load() << " generations, " << wallMs << " ms wall):" << std::endl;
+        for (int p = 0; p < Phases; p++) {
+            double ms = static_cast<double>(phaseNs[p].load()) / 1e6;
+            if (phaseCalls[p].load() == 0) continue;
+            char line[128];
+            std::snprintf(line, sizeof(line), "  %-12s %12.3f ms %6.1f%% %10llu calls", phaseNames[p], ms,
+                          wallMs > 0 ? 100.0 * ms / wallMs : 0.0, static_cast<unsigned long long>(phaseCalls[p].load()));
+            out << line << std::endl;
         }
-    }
+        double evolveSeconds = static_cast<double>(phaseNs[Evolve].load()) / 1e9;
+        out << "  Cells updated: " << cellsUpdated.load();
+        if (evolveSeconds > 0) out << " (" << static_cast<double>(cellsUpdated.load()) / evolveSeconds / 1e6 << " Mcells/s)";
+        out << std::endl;
 
-    // Load world from file
-    bool load(const std::string& filename) {
-        std::ifstream file(filename);
-        if (!file.is_open()) {
-            std::cerr << "Error: Could not open file " << filename << std::endl;
-            return false;
+        double minBusy, meanBusy, maxBusy, totalWait;
+        int active = threadSummary(minBusy, meanBusy, maxBusy, totalWait);
+        if (active > 0) {
+            out << "  Threads: " << active << ", band time min/mean/max " << minBusy << "/" << meanBusy << "/" << maxBusy
+                << " ms, imbalance " << (meanBusy > 0 ? maxBusy / meanBusy : 1.0) << ", barrier wait " << totalWait
+                << " ms" << std::endl;
         }
-        
-        file >> width >> height;
-        
-        // Resize and initialize grids
-        current.resize(height, std::vector<bool>(width, false));
-        next.resize(height, std::vector<bool>(width, false));
-        
-        // Read cell states
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                int state;
-                file >> state;
-                current[y][x] = (state == 1);
-            }
+        uint64_t allocated = allocationCount();
+        out << "  Allocations: " << allocated;
+        if (generations.load() > 0) out << " (" << static_cast<double>(allocated) / generations.load() << " per generation)";
+        out << std::endl;
+        if (hasHardware()) {
+            uint64_t counts[hardwareEvents];
+            hardwareDelta(counts);
+            out << "  Hardware: " << counts[0] << " cycles, " << counts[1] << " instructions (IPC "
+                << (counts[0] ? static_cast<double>(counts[1]) / counts[0] : 0.0) << "), " << counts[3]
+                << " cache misses of " << counts[2] << " references" << std::endl;
         }
-        
-        // Reset history
-        history.clear();
-        history.push_back(current);
-        
-        file.close();
-        return true;
     }
 
-    // Save world to file
-    bool save(const std::string& filename) {
+    bool writeJSON(const std::string& filename) const {
         std::ofstream file(filename);
         if (!file.is_open()) {
             std::cerr << "Error: Could not open file " << filename << std::endl;
             return false;
         }
-        
-        // Write dimensions
-        file << width << " " << height << std::endl;
-        
-        // Write cell states
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                file << (current[y][x] ? 1 : 0) << " ";
-            }
-            file << std::endl;
+        double wallMs = static_cast<double>((endNs ? endNs : now()) - beginNs) / 1e6;
+        file << "{\n  \"generations\": " << generations.load() << ",\n  \"wall_ms\": " << wallMs
+             << ",\n  \"cells_updated\": " << cellsUpdated.load() << ",\n  \"allocations\": " << allocationCount()
+             << ",\n  \"phases\": {";
+        for (int p = 0; p < Phases; p++) {
+            file << (p ? "," : "") << "\n    \"" << phaseNames[p] << "\": {\"ms\": "
+                 << static_cast<double>(phaseNs[p].load()) / 1e6 << ", \"calls\": " << phaseCalls[p].load() << "}";
         }
-        
+        file << "\n  },\n  \"threads\": [";
+        bool first = true;
+        for (int t = 0; t < maxThreads; t++) {
+            if (threads[t].busyNs.load() == 0 && threads[t].waitNs.load() == 0) continue;
+            file << (first ? "" : ",") << "\n    {\"thread\": " << t << ", \"band_ms\": "
+                 << static_cast<double>(threads[t].busyNs.load()) / 1e6 << ", \"wait_ms\": "
+                 << static_cast<double>(threads[t].waitNs.load()) / 1e6 << "}";
+            first = false;
+        }
+        file << "\n  ]";
+        if (hasHardware()) {
+            uint64_t counts[hardwareEvents];
+            hardwareDelta(counts);
+            file << ",\n  \"hardware\": {\"cycles\": " << counts[0] << ", \"instructions\": " << counts[1]
+                 << ", \"cache_references\": " << counts[2] << ", \"cache_misses\": " << counts[3] << "}";
+        }
+        file << "\n}\n";
         file.close();
+        if (!file.good()) {
+            std::cerr << "Error: Could not write file " << filename << std::endl;
+            return false;
+        }
         return true;
     }
 
-    // Get cell state from 2D coordinates
-    bool getCell(int x, int y) {
-        if (x < 0 || x >= width || y < 0 || y >= height) {
-            return false;
-        }
-        return current[y][x];
+private:
+    static constexpr int hardwareEvents = 4; // cycles, instructions, cache references, cache misses
+#ifdef __linux__
+    static constexpr uint64_t hardwareConfigs[hardwareEvents] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_REFERENCES, PERF_COUNT_HW_CACHE_MISSES
+    };
+#endif
+    static constexpr const char* phaseNames[Phases] = {
+        "evolve", "cycle check", "advance", "render", "checkpoint", "record"
+    };
+
+    // Padded so that threads adding their own times do not share cache lines
+    struct alignas(64) ThreadTimes {
+        std::atomic<uint64_t> busyNs{ 0 };
+        std::atomic<uint64_t> waitNs{ 0 };
+        int fds[hardwareEvents] = { -1, -1, -1, -1 };
+    };
+
+    std::atomic<bool> enabled{ true };
+    std::atomic<uint64_t> phaseNs[Phases] = {};
+    std::atomic<uint64_t> phaseCalls[Phases] = {};
+    ThreadTimes threads[maxThreads];
+    std::atomic<uint64_t> cellsUpdated{ 0 };
+    std::atomic<uint64_t> generations{ 0 };
+    uint64_t allocationsAtBegin = 0;
+    uint64_t allocationsAtEnd = 0;
+    uint64_t beginNs = 0;
+    uint64_t endNs = 0;
+    int hardwareThreads = 0;
+    uint64_t hardwareAtBegin[hardwareEvents] = {};
+    uint64_t hardwareAtEnd[hardwareEvents] = {};
+
+    Profiler() {}
+
+    ~Profiler() {
+        closeHardware();
     }
 
-    // Get cell state from 1D index
-    bool getCell(int position) {
-        int x = position % width;
-        int y = position / width;
-        return getCell(x, y);
+    uint64_t allocationCount() const {
+        return (endNs ? allocationsAtEnd : allocations().load()) - allocationsAtBegin;
     }
 
-    // Set cell state using 2D coordinates
-    void setCell(int x, int y, bool state) {
-        if (x < 0 || x >= width || y < 0 || y >= height) {
-            return;
+    // Band time over the threads that evolved bands (ms)
+    int threadSummary(double& minBusy, double& meanBusy, double& maxBusy, double& totalWait) const {
+        int active = 0;
+        minBusy = meanBusy = maxBusy = totalWait = 0;
+        for (const ThreadTimes& t : threads) {
+            double busy = static_cast<double>(t.busyNs.load()) / 1e6;
+            if (busy == 0) continue;
+            minBusy = active ? std::min(minBusy, busy) : busy;
+            maxBusy = std::max(maxBusy, busy);
+            meanBusy += busy;
+            totalWait += static_cast<double>(t.waitNs.load()) / 1e6;
+            active++;
         }
-        current[y][x] = state;
+        if (active) meanBusy /= active;
+        return active;
     }
 
-    // Set cell state using 1D index
-    void setCell(int position, bool state) {
-        int x = position % width;
-        int y = position / width;
-        setCell(x, y, state);
+    // Sum each hardware event over the threads
+    void readHardware(uint64_t* counts) const {
+        for (int e = 0; e < hardwareEvents; e++) {
+            counts[e] = 0;
+#ifdef __linux__
+            for (int t = 0; t < hardwareThreads; t++) {
+                uint64_t value = 0;
+                if (threads[t].fds[e] >= 0 && read(threads[t].fds[e], &value, sizeof(value)) == sizeof(value)) {
+                    counts[e] += value;
+                }
+            }
+#endif
+        }
     }
 
-    // Add a glider pattern
-    void addGlider(int x, int y) {
-        // Glider pattern:
-        // □■□
-        // □□■
-        // ■■■
-        setCell((x + 1) % width, y % height, true);
-        setCell((x + 2) % width, (y + 1) % height, true);
-        setCell(x % width, (y + 2) % height, true);
-        setCell((x + 1) % width, (y + 2) % height, true);
-        setCell((x + 2) % width, (y + 2) % height, true);
+    void hardwareDelta(uint64_t* counts) const {
+        uint64_t current[hardwareEvents];
+        if (endNs) {
+            std::copy(hardwareAtEnd, hardwareAtEnd + hardwareEvents, current);
+        } else {
+            readHardware(current);
+        }
+        for (int e = 0; e < hardwareEvents; e++) counts[e] = current[e] - hardwareAtBegin[e];
     }
 
-    // Add a toad pattern (period-2 oscillator)
-    void addToad(int x, int y) {
-        // Toad pattern:
-        // □□□□
-        // □■■■
-        // ■■■□
-        // □□□□
-        setCell((x + 1) % width, (y + 1) % height, true);
-        setCell((x + 2) % width, (y + 1) % height, true);
-        setCell((x + 3) % width, (y + 1) % height, true);
-        setCell(x % width, (y + 2) % height, true);
-        setCell((x + 1) % width, (y + 2) % height, true);
-        setCell((x + 2) % width, (y + 2) % height, true);
+    void closeHardware() {
+        for (ThreadTimes& t : threads) {
+            for (int& fd : t.fds) {
+#ifdef __linux__
+                if (fd >= 0) close(fd);
+#endif
+                fd = -1;
+            }
+        }
+        hardwareThreads = 0;
+        std::fill(hardwareAtBegin, hardwareAtBegin + hardwareEvents, 0);
+        std::fill(hardwareAtEnd, hardwareAtEnd + hardwareEvents, 0);
     }
+};
 
-    // Add a beacon pattern (period-2 oscillator)
-    void addBeacon(int x, int y) {
-        // Beacon pattern:
-        // ■■□□
-        // ■■□□
-        // □□■■
-        // □□■■
-        setCell(x % width, y % height, true);
-        setCell((x + 1) % width, y % height, true);
-        setCell(x % width, (y + 1) % height, true);
-        setCell((x + 1) % width, (y + 1) % height, true);
-        setCell((x + 2) % width, (y + 2) % height, true);
-        setCell((x + 3) % width, (y + 2) % height, true);
-        setCell((x + 2) % width, (y + 3) % height, true);
-        setCell((x + 3) % width, (y + 3) % height, true);
-    }
+// Count every heap allocation of the program. The replacements stay out of
+// line, so GCC does not pair an inlined free() with an operator new call.
+#ifdef __GNUC__
+#define GOL_ALLOC_NOINLINE __attribute__((noinline))
+#else
+#define GOL_ALLOC_NOINLINE
+#endif
 
-    // Add a methuselah pattern (R-pentomino)
-    void addMethuselah(int x, int y) {
-        // R-pentomino pattern (a long-lived methuselah):
-        // □■■
-        // ■■□
-        // □■□
-        setCell((x + 1) % width, y % height, true);
-        setCell((x + 2) % width, y % height, true);
-        setCell(x % width, (y + 1) % height, true);
-        setCell((x + 1) % width, (y + 1) % height, true);
-        setCell((x + 1) % width, (y + 2) % height, true);
+GOL_ALLOC_NOINLINE void* operator new(size_t size) {
+    Profiler::allocations().fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+GOL_ALLOC_NOINLINE void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+GOL_ALLOC_NOINLINE void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+GOL_ALLOC_NOINLINE void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+GOL_ALLOC_NOINLINE void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+GOL_ALLOC_NOINLINE void operator delete[](void* p, size_t) noexcept {
+    std::free(p);
+}
+
+// Time the rest of the enclosing scope as one call of a phase
+class ProfileScope {
+private:
+    Profiler::Phase phase;
+    uint64_t start;
+
+public:
+    explicit ProfileScope(Profiler::Phase p)
+        : phase(p), start(Profiler::instance().isEnabled() ? Profiler::now() : 0) {}
+
+    ~ProfileScope() {
+        if (start) Profiler::instance().addPhase(phase, Profiler::now() - start);
     }
 
-    // Add random patterns - PARALLELIZED VERSION
-    void addRandomPatterns(int count) {
-        std::random_device rd;
-        
-        // Create separate random generators for each thread to avoid race conditions
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+#define GOL_PROFILE_SCOPE(phase) ProfileScope profileScope(Profiler::phase)
+#define GOL_PROFILE_START() (Profiler::instance().isEnabled() ? Profiler::now() : 0)
+#define GOL_PROFILE_BAND(thread, start) \
+    do { if (start) Profiler::instance().addBand(thread, Profiler::now() - (start)); } while (0)
+#define GOL_PROFILE_WAIT(thread, start) \
+    do { if (start) Profiler::instance().addWait(thread, Profiler::now() - (start)); } while (0)
+#define GOL_PROFILE_PHASE(phase, start) \
+    do { if (start) Profiler::instance().addPhase(Profiler::phase, Profiler::now() - (start)); } while (0)
+#define GOL_PROFILE_CELLS(cells) \
+    do { if (Profiler::instance().isEnabled()) Profiler::instance().addCells(cells); } while (0)
+#else
+#define GOL_PROFILE_SCOPE(phase) ((void)0)
+#define GOL_PROFILE_START() uint64_t(0)
+#define GOL_PROFILE_BAND(thread, start) ((void)(thread), (void)(start))
+#define GOL_PROFILE_WAIT(thread, start) ((void)(thread), (void)(start))
+#define GOL_PROFILE_PHASE(phase, start) ((void)(start))
+#define GOL_PROFILE_CELLS(cells) ((void)0)
+#endif
+
+// BitGrid class - bit-packed grid storage, one bit per cell
+// Each row is stored as a contiguous run of 64-bit words; bit i of word w holds
+// cell x = w * 64 + i. Padding bits past the row width are always kept zero.
+// Rows are first written in parallel row bands (see rowBand), which places
+// each band's pages on the NUMA node of the thread that evolves it.
+class BitGrid {
+private:
+    int width;                   // Width of the grid in cells
+    int height;                  // Height of the grid in cells
+    int wordsPerRow;             // Number of 64-bit words per row
+    std::vector<uint64_t, FirstTouchAllocator<uint64_t>> words; // Row-major word storage
+
+    // Write every row from the thread owning its band: zeros, or source's rows
+    void placeRows(const BitGrid* source) {
         #pragma omp parallel
         {
-            std::mt19937 gen(rd() + omp_get_thread_num());
-            std::uniform_int_distribution<> disX(0, width - 1);
-            std::uniform_int_distribution<> disY(0, height - 1);
-            std::uniform_int_distribution<> disPattern(0, 3);
-            
-            #pragma omp for schedule(static)
-            for (int i = 0; i < count; i++) {
-                int x = disX(gen);
-                int y = disY(gen);
-                int pattern = disPattern(gen);
-                
-                // Critical section to avoid race conditions when modifying the grid
-                #pragma omp critical
-                {
-                    switch (pattern) {
-                        case 0: addGlider(x, y); break;
-                        case 1: addToad(x, y); break;
-                        case 2: addBeacon(x, y); break;
-                        case 3: addMethuselah(x, y); break;
-                    }
-                }
+            int begin, end;
+            rowBand(height, omp_get_thread_num(), omp_get_num_threads(), begin, end);
+            size_t first = static_cast<size_t>(begin) * wordsPerRow;
+            size_t last = static_cast<size_t>(end) * wordsPerRow;
+            if (source) {
+                std::copy(source->words.begin() + first, source->words.begin() + last, words.begin() + first);
+            } else {
+                std::fill(words.begin() + first, words.begin() + last, 0);
             }
         }
     }
 
-    // Get world width
-    int getWidth() const {
-        return width;
+public:
+    BitGrid() : width(0), height(0), wordsPerRow(0) {}
+
+    BitGrid(int w, int h) : width(w), height(h), wordsPerRow((w + 63) / 64) {
+        words.resize(static_cast<size_t>(wordsPerRow) * height);
+        placeRows(nullptr);
     }
 
-    // Get world height
-    int getHeight() const {
-        return height;
+    BitGrid(const BitGrid& other) : width(other.width), height(other.height), wordsPerRow(other.wordsPerRow) {
+        words.resize(other.words.size());
+        placeRows(&other);
     }
 
-    // Benchmark function to test performance
-    double benchmarkEvolution(int generations) {
-        auto start = std::chrono::high_resolution_clock::now();
-        
-        for (int i = 0; i < generations; i++) {
-            evolve();
+    BitGrid& operator=(const BitGrid& other) {
+        if (this == &other) return *this;
+        if (words.size() != other.words.size()) {
+            // Fresh, untouched storage rather than a serial reallocation copy
+            words = std::vector<uint64_t, FirstTouchAllocator<uint64_t>>();
+            words.resize(other.words.size());
         }
-        
-        auto end = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double, std::milli> elapsed = end - start;
-        return elapsed.count();
+        width = other.width;
+        height = other.height;
+        wordsPerRow = other.wordsPerRow;
+        placeRows(&other);
+        return *this;
+    }
+
+    BitGrid(BitGrid&&) = default;
+    BitGrid& operator=(BitGrid&&) = default;
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getWordsPerRow() const { return wordsPerRow; }
+
+    // Number of valid bits in the last word of each row (1..64)
+    int lastWordBits() const {
+        return width - (wordsPerRow - 1) * 64;
+    }
+
+    // Mask selecting the valid bits of the last word of each row
+    uint64_t lastWordMask() const {
+        int bits = lastWordBits();
+        return bits == 64 ? ~0ULL : ((1ULL << bits) - 1);
+    }
+
+    uint64_t* row(int y) {
+        return words.data() + static_cast<size_t>(y) * wordsPerRow;
+    }
+
+    const uint64_t* row(int y) const {
+        return words.data() + static_cast<size_t>(y) * wordsPerRow;
+    }
+
+    bool get(int x, int y) const {
+        return (row(y)[x >> 6] >> (x & 63)) & 1;
+    }
+
+    void set(int x, int y, bool state) {
+        uint64_t bit = 1ULL << (x & 63);
+        if (state) {
+            row(y)[x >> 6] |= bit;
+        } else {
+            row(y)[x >> 6] &= ~bit;
+        }
+    }
+
+    // Set every cell to dead
+    void clear() {
+        std::fill(words.begin(), words.end(), 0);
+    }
+
+    bool operator==(const BitGrid& other) const {
+        return width == other.width && height == other.height && words == other.words;
     }
 };
 
-// CommandLine class - handles user interaction
-class CommandLine {
-private:
-    GameOfLife* world;
-    bool printEnabled;
-    int delayTime;
-    bool stabilityCheckEnabled;
+// LifeRule - an outer-totalistic rule in B/S notation. Generations rules
+// (states > 2) add dying states: a live cell that does not survive steps
+// through states 2 .. states-1 before it is dead, and cannot be born again
+// (or count as a neighbour) until then.
+struct LifeRule {
+    uint16_t birth;   // Bit n set: a dead cell with n live neighbours is born
+    uint16_t survive; // Bit n set: a live cell with n live neighbours survives
+    int states;       // 2 for Life-like rules
 
-public:
-    CommandLine() : world(nullptr), printEnabled(true), delayTime(100), stabilityCheckEnabled(true) {}
+    LifeRule() : birth(1 << 3), survive((1 << 2) | (1 << 3)), states(2) {}
 
-    ~CommandLine() {
-        if (world) delete world;
+    bool operator==(const LifeRule& other) const {
+        return birth == other.birth && survive == other.survive && states == other.states;
     }
 
-    // Process a single command
-    bool processCommand(const std::string& input) {
-        std::istringstream iss(input);
-        std::string command;
-        iss >> command;
+    bool operator!=(const LifeRule& other) const {
+        return !(*this == other);
+    }
+
+    bool isLife() const {
+        return *this == LifeRule();
+    }
+
+    bool isGenerations() const {
+        return states > 2;
+    }
+
+    // B/S notation, e.g. "B36/S23" or "B2/S/C3"
+    std::string toString() const {
+        std::string result = "B";
+        for (int n = 0; n <= 8; n++) {
+            if ((birth >> n) & 1) result += static_cast<char>('0' + n);
+        }
+        result += "/S";
+        for (int n = 0; n <= 8; n++) {
+            if ((survive >> n) & 1) result += static_cast<char>('0' + n);
+        }
+        if (isGenerations()) result += "/C" + std::to_string(states);
+        return result;
+    }
+
+    // Parse B/S notation ("B36/S23", "B2/S/C3"), the S/B/C form ("23/36",
+    // "/2/3") or a rule name. Rules with B0 are rejected: empty space would
+    // not stay empty, which sparse worlds, active tiles and HashLife rely on.
+    static bool parse(std::string spec, LifeRule& rule) {
+        std::transform(spec.begin(), spec.end(), spec.begin(), [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+        static const std::pair<const char*, const char*> names[] = {
+            { "LIFE", "B3/S23" }, { "HIGHLIFE", "B36/S23" }, { "DAYNIGHT", "B3678/S34678" },
+            { "SEEDS", "B2/S" }, { "BRIANSBRAIN", "B2/S/C3" }, { "STARWARS", "B2/S345/C4" }
+        };
+        for (const auto& name : names) {
+            if (spec == name.first) spec = name.second;
+        }
+
+        // Split into '/' separated fields
+        std::vector<std::string> fields(1);
+        for (char c : spec) {
+            if (c == '/') fields.emplace_back();
+            else fields.back() += c;
+        }
+        if (fields.size() < 2 || fields.size() > 3) return false;
+
+        LifeRule result;
+        result.birth = result.survive = 0;
+        bool tagged = !fields[0].empty() && (fields[0][0] == 'B' || fields[0][0] == 'S');
+        bool haveB = false, haveS = false;
+        for (size_t i = 0; i < fields.size(); i++) {
+            std::string field = fields[i];
+            char kind;
+            if (tagged) {
+                if (field.empty()) return false;
+                kind = field[0];
+                field.erase(0, 1);
+            } else {
+                kind = (i == 0) ? 'S' : (i == 1 ? 'B' : 'C');
+            }
+            if (kind == 'C' || kind == 'G') {
+                if (i != 2 || field.empty() || field.size() > 3 ||
+                    !std::all_of(field.begin(), field.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+                    return false;
+                }
+                result.states = std::atoi(field.c_str());
+                if (result.states < 2 || result.states > 255) return false;
+                continue;
+            }
+            if ((kind == 'B' && haveB) || (kind == 'S' && haveS) || (kind != 'B' && kind != 'S')) return false;
+            uint16_t& mask = (kind == 'B') ? result.birth : result.survive;
+            (kind == 'B' ? haveB : haveS) = true;
+            for (char c : field) {
+                if (c < '0' || c > '8') return false;
+                mask |= 1 << (c - '0');
+            }
+        }
+        if (!haveB || !haveS || (result.birth & 1)) return false;
+        rule = result;
+        return true;
+    }
+};
+
+// Add three 64-lane bit vectors, producing a sum bit and a carry bit per lane.
+// V is uint64_t or a vector of them (GCC vector extension).
+template <typename V>
+static inline void fullAdd(const V& a, const V& b, const V& c, V& sum, V& carry) {
+    V t = a ^ b;
+    sum = t ^ c;
+    carry = (a & b) | (t & c);
+}
+
+// Compute the west (x-1) and east (x+1) neighbours of word w of a row, aligned to
+// the cells of word w, wrapping around the row ends for the toroidal world
+static inline void horizontalNeighbors(const uint64_t* row, int w, int nWords, int lastBits,
+                                       uint64_t& west, uint64_t& east) {
+    uint64_t carryIn = (w > 0) ? (row[w - 1] >> 63) : ((row[nWords - 1] >> (lastBits - 1)) & 1);
+    uint64_t carryOut = (w < nWords - 1) ? (row[w + 1] << 63) : ((row[0] & 1) << (lastBits - 1));
+    west = (row[w] << 1) | carryIn;
+    east = (row[w] >> 1) | carryOut;
+}
+
+// Apply B3/S23 to 64 cells at once given the eight neighbour bit vectors.
+// The neighbour count is summed with a full-adder tree: a cell lives in the next
+// generation if the count is 3, or if it is 2 and the cell is currently alive.
+static inline uint64_t lifeWord(uint64_t aW, uint64_t a, uint64_t aE,
+                                uint64_t bW, uint64_t b, uint64_t bE,
+                                uint64_t cW, uint64_t c, uint64_t cE) {
+    uint64_t s1, c1, s2, c2, ones, twosA, t1, t2;
+    fullAdd(aW, a, aE, s1, c1);
+    fullAdd(cW, c, cE, s2, c2);
+    uint64_t s3 = bW ^ bE;
+    uint64_t c3 = bW & bE;
+    fullAdd(s1, s2, s3, ones, twosA);
+    fullAdd(c1, c2, c3, t1, t2);
+    // Count is 2 or 3 exactly when the fours bit is clear and one twos bit is set
+    return ~t2 & (t1 ^ twosA) & (ones | b);
+}
+
+// Row kernel signature: evolve the interior words [begin, end) of a packed row.
+// Callers guarantee 1 <= begin and end <= nWords - 1, so words w - 1 and w + 1
+// are always in range and no wrap-around handling is needed. Kernels
+// specialized for one rule ignore the rule argument.
+typedef void (*RowKernel)(const uint64_t* above, const uint64_t* row, const uint64_t* below,
+                          uint64_t* out, int begin, int end, const LifeRule& rule);
+
+// Word kernel signature: apply a rule to 64 cells given the neighbour vectors
+typedef uint64_t (*WordKernel)(uint64_t aW, uint64_t a, uint64_t aE,
+                               uint64_t bW, uint64_t b, uint64_t bE,
+                               uint64_t cW, uint64_t c, uint64_t cE, const LifeRule& rule);
+
+// Portable scalar SWAR kernel, 64 cells per iteration
+static void rowKernelScalar(const uint64_t* above, const uint64_t* row, const uint64_t* below,
+                            uint64_t* out, int begin, int end, const LifeRule&) {
+    for (int w = begin; w < end; w++) {
+        out[w] = lifeWord((above[w] << 1) | (above[w - 1] >> 63), above[w],
+                          (above[w] >> 1) | (above[w + 1] << 63),
+                          (row[w] << 1) | (row[w - 1] >> 63), row[w],
+                          (row[w] >> 1) | (row[w + 1] << 63),
+                          (below[w] << 1) | (below[w - 1] >> 63), below[w],
+                          (below[w] >> 1) | (below[w + 1] << 63));
+    }
+}
+
+#ifdef GOL_X86_SIMD
+// SSE2 kernel, 128 cells per iteration
+__attribute__((target("sse2")))
+static inline __m128i lifeVecSSE2(const uint64_t* above, const uint64_t* row, const uint64_t* below, int w) {
+    const uint64_t* rows[3] = { above, row, below };
+    __m128i west[3], mid[3], east[3];
+    for (int r = 0; r < 3; r++) {
+        __m128i prev = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[r] + w - 1));
+        __m128i cur = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[r] + w));
+        __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[r] + w + 1));
+        west[r] = _mm_or_si128(_mm_slli_epi64(cur, 1), _mm_srli_epi64(prev, 63));
+        east[r] = _mm_or_si128(_mm_srli_epi64(cur, 1), _mm_slli_epi64(next, 63));
+        mid[r] = cur;
+    }
+    // Same full-adder tree as lifeWord()
+    __m128i t, s1, c1, s2, c2, ones, twosA, t1, t2;
+    t = _mm_xor_si128(west[0], mid[0]);
+    s1 = _mm_xor_si128(t, east[0]);
+    c1 = _mm_or_si128(_mm_and_si128(west[0], mid[0]), _mm_and_si128(t, east[0]));
+    t = _mm_xor_si128(west[2], mid[2]);
+    s2 = _mm_xor_si128(t, east[2]);
+    c2 = _mm_or_si128(_mm_and_si128(west[2], mid[2]), _mm_and_si128(t, east[2]));
+    __m128i s3 = _mm_xor_si128(west[1], east[1]);
+    __m128i c3 = _mm_and_si128(west[1], east[1]);
+    t = _mm_xor_si128(s1, s2);
+    ones = _mm_xor_si128(t, s3);
+    twosA = _mm_or_si128(_mm_and_si128(s1, s2), _mm_and_si128(t, s3));
+    t = _mm_xor_si128(c1, c2);
+    t1 = _mm_xor_si128(t, c3);
+    t2 = _mm_or_si128(_mm_and_si128(c1, c2), _mm_and_si128(t, c3));
+    return _mm_andnot_si128(t2, _mm_and_si128(_mm_xor_si128(t1, twosA), _mm_or_si128(ones, mid[1])));
+}
+
+__attribute__((target("sse2")))
+static void rowKernelSSE2(const uint64_t* above, const uint64_t* row, const uint64_t* below,
+                          uint64_t* out, int begin, int end, const LifeRule& rule) {
+    int w = begin;
+    for (; w + 2 <= end; w += 2) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + w), lifeVecSSE2(above, row, below, w));
+    }
+    rowKernelScalar(above, row, below, out, w, end, rule);
+}
+
+// AVX2 kernel, 256 cells per iteration
+__attribute__((target("avx2")))
+static inline __m256i lifeVecAVX2(const uint64_t* above, const uint64_t* row, const uint64_t* below, int w) {
+    const uint64_t* rows[3] = { above, row, below };
+    __m256i west[3], mid[3], east[3];
+    for (int r = 0; r < 3; r++) {
+        __m256i prev = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[r] + w - 1));
+        __m256i cur = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[r] + w));
+        __m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[r] + w + 1));
+        west[r] = _mm256_or_si256(_mm256_slli_epi64(cur, 1), _mm256_srli_epi64(prev, 63));
+        east[r] = _mm256_or_si256(_mm256_srli_epi64(cur, 1), _mm256_slli_epi64(next, 63));
+        mid[r] = cur;
+    }
+    // Same full-adder tree as lifeWord()
+    __m256i t, s1, c1, s2, c2, ones, twosA, t1, t2;
+    t = _mm256_xor_si256(west[0], mid[0]);
+    s1 = _mm256_xor_si256(t, east[0]);
+    c1 = _mm256_or_si256(_mm256_and_si256(west[0], mid[0]), _mm256_and_si256(t, east[0]));
+    t = _mm256_xor_si256(west[2], mid[2]);
+    s2 = _mm256_xor_si256(t, east[2]);
+    c2 = _mm256_or_si256(_mm256_and_si256(west[2], mid[2]), _mm256_and_si256(t, east[2]));
+    __m256i s3 = _mm256_xor_si256(west[1], east[1]);
+    __m256i c3 = _mm256_and_si256(west[1], east[1]);
+    t = _mm256_xor_si256(s1, s2);
+    ones = _mm256_xor_si256(t, s3);
+    twosA = _mm256_or_si256(_mm256_and_si256(s1, s2), _mm256_and_si256(t, s3));
+    t = _mm256_xor_si256(c1, c2);
+    t1 = _mm256_xor_si256(t, c3);
+    t2 = _mm256_or_si256(_mm256_and_si256(c1, c2), _mm256_and_si256(t, c3));
+    return _mm256_andnot_si256(t2, _mm256_and_si256(_mm256_xor_si256(t1, twosA), _mm256_or_si256(ones, mid[1])));
+}
+
+__attribute__((target("avx2")))
+static void rowKernelAVX2(const uint64_t* above, const uint64_t* row, const uint64_t* below,
+                          uint64_t* out, int begin, int end, const LifeRule& rule) {
+    int w = begin;
+    for (; w + 4 <= end; w += 4) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + w), lifeVecAVX2(above, row, below, w));
+    }
+    // GCC turns the tail into a sibling call without clearing the upper
+    // register halves, and the SSE code of the scalar kernel then runs at a
+    // fraction of its speed on narrow rows
+    _mm256_zeroupper();
+    rowKernelScalar(above, row, below, out, w, end, rule);
+}
+
+// GCC 12 headers trip -Wuninitialized on _mm512_undefined_epi32() in unoptimized builds
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+
+// AVX-512 kernel, 512 cells per iteration. The adders use ternary logic:
+// 0x96 is the three-input XOR (sum) and 0xE8 the three-input majority (carry).
+__attribute__((target("avx512f")))
+static inline __m512i lifeVecAVX512(const uint64_t* above, const uint64_t* row, const uint64_t* below, int w) {
+    const uint64_t* rows[3] = { above, row, below };
+    __m512i west[3], mid[3], east[3];
+    for (int r = 0; r < 3; r++) {
+        __m512i prev = _mm512_loadu_si512(rows[r] + w - 1);
+        __m512i cur = _mm512_loadu_si512(rows[r] + w);
+        __m512i next = _mm512_loadu_si512(rows[r] + w + 1);
+        west[r] = _mm512_or_si512(_mm512_slli_epi64(cur, 1), _mm512_srli_epi64(prev, 63));
+        east[r] = _mm512_or_si512(_mm512_srli_epi64(cur, 1), _mm512_slli_epi64(next, 63));
+        mid[r] = cur;
+    }
+    __m512i s1 = _mm512_ternarylogic_epi64(west[0], mid[0], east[0], 0x96);
+    __m512i c1 = _mm512_ternarylogic_epi64(west[0], mid[0], east[0], 0xE8);
+    __m512i s2 = _mm512_ternarylogic_epi64(west[2], mid[2], east[2], 0x96);
+    __m512i c2 = _mm512_ternarylogic_epi64(west[2], mid[2], east[2], 0xE8);
+    __m512i s3 = _mm512_xor_si512(west[1], east[1]);
+    __m512i c3 = _mm512_and_si512(west[1], east[1]);
+    __m512i ones = _mm512_ternarylogic_epi64(s1, s2, s3, 0x96);
+    __m512i twosA = _mm512_ternarylogic_epi64(s1, s2, s3, 0xE8);
+    __m512i t1 = _mm512_ternarylogic_epi64(c1, c2, c3, 0x96);
+    __m512i t2 = _mm512_ternarylogic_epi64(c1, c2, c3, 0xE8);
+    return _mm512_andnot_si512(t2, _mm512_and_si512(_mm512_xor_si512(t1, twosA), _mm512_or_si512(ones, mid[1])));
+}
+
+__attribute__((target("avx512f")))
+static void rowKernelAVX512(const uint64_t* above, const uint64_t* row, const uint64_t* below,
+                            uint64_t* out, int begin, int end, const LifeRule& rule) {
+    int w = begin;
+    for (; w + 8 <= end; w += 8) {
+        _mm512_storeu_si512(out + w, lifeVecAVX512(above, row, below, w));
+    }
+    _mm256_zeroupper(); // See rowKernelAVX2()
+    rowKernelScalar(above, row, below, out, w, end, rule);
+}
+
+#pragma GCC diagnostic pop
+#endif
+
+// Kernels for other rules. The neighbour count is summed into bit planes
+// (count = ones + 2 twos + 4 fours + 8 eights) and the rule is a sum of
+// products over those planes. StaticRule fixes the rule at compile time, so
+// the terms fold into constant bit logic; DynamicRule reads it at run time.
+template <typename V>
+static inline void neighbourCount(const V& aW, const V& a, const V& aE, const V& bW, const V& bE,
+                                  const V& cW, const V& c, const V& cE,
+                                  V& ones, V& twos, V& fours, V& eights) {
+    V s1, c1, s2, c2, twosA, t1, t2;
+    fullAdd(aW, a, aE, s1, c1);
+    fullAdd(cW, c, cE, s2, c2);
+    V s3 = bW ^ bE;
+    V c3 = bW & bE;
+    fullAdd(s1, s2, s3, ones, twosA);
+    fullAdd(c1, c2, c3, t1, t2);
+    twos = twosA ^ t1;
+    V carry = twosA & t1;
+    fours = t2 ^ carry;
+    eights = t2 & carry;
+}
+
+// Lanes whose neighbour count is exactly n
+template <typename V>
+static inline void countIs(int n, const V& ones, const V& twos, const V& fours, const V& eights, V& result) {
+    if (n == 8) {
+        result = eights;
+        return;
+    }
+    result = ((n & 1) ? ones : ~ones) & ((n & 2) ? twos : ~twos) & ((n & 4) ? fours : ~fours);
+    // Count 8 has the three low planes clear, like count 0
+    if (n == 0) result &= ~eights;
+}
+
+template <unsigned Birth, unsigned Survive>
+struct StaticRule {
+    template <int N, typename V>
+    static inline void term(const V& ones, const V& twos, const V& fours, const V& eights, const V& alive, V& out) {
+        constexpr bool born = (Birth >> N) & 1, survives = (Survive >> N) & 1;
+        if constexpr (born || survives) {
+            V match;
+            countIs(N, ones, twos, fours, eights, match);
+            if constexpr (born && survives) {
+                out |= match;
+            } else if constexpr (born) {
+                out |= match & ~alive;
+            } else {
+                out |= match & alive;
+            }
+        }
+    }
+
+    template <typename V, int... N>
+    static inline void terms(const V& ones, const V& twos, const V& fours, const V& eights, const V& alive, V& out,
+                             std::integer_sequence<int, N...>) {
+        (term<N>(ones, twos, fours, eights, alive, out), ...);
+    }
+
+    template <typename V>
+    static inline void apply(const V& ones, const V& twos, const V& fours, const V& eights, const V& alive,
+                             const LifeRule&, V& out) {
+        out = alive ^ alive;
+        terms(ones, twos, fours, eights, alive, out, std::make_integer_sequence<int, 9>());
+    }
+};
+
+struct DynamicRule {
+    template <typename V>
+    static inline void apply(const V& ones, const V& twos, const V& fours, const V& eights, const V& alive,
+                             const LifeRule& rule, V& out) {
+        out = alive ^ alive;
+        for (int n = 0; n <= 8; n++) {
+            bool born = (rule.birth >> n) & 1, survives = (rule.survive >> n) & 1;
+            if (!born && !survives) continue;
+            V match;
+            countIs(n, ones, twos, fours, eights, match);
+            if (born && survives) {
+                out |= match;
+            } else if (born) {
+                out |= match & ~alive;
+            } else {
+                out |= match & alive;
+            }
+        }
+    }
+};
+
+typedef StaticRule<(1 << 3) | (1 << 6), (1 << 2) | (1 << 3)> HighLifeRule;
+typedef StaticRule<(1 << 3) | (1 << 6) | (1 << 7) | (1 << 8),
+                   (1 << 3) | (1 << 4) | (1 << 6) | (1 << 7) | (1 << 8)> DayNightRule;
+typedef StaticRule<(1 << 2), 0> SeedsRule;
+
+// Evolve words from w while a whole vector fits before end, advancing w
+template <class Rule, typename V>
+static inline void rowKernelRuleLoop(const uint64_t* above, const uint64_t* row, const uint64_t* below,
+                                     uint64_t* out, int& w, int end, const LifeRule& rule) {
+    const int lanes = static_cast<int>(sizeof(V) / sizeof(uint64_t));
+    const uint64_t* rows[3] = { above, row, below };
+    for (; w + lanes <= end; w += lanes) {
+        V west[3], mid[3], east[3];
+        for (int r = 0; r < 3; r++) {
+            V prev, next;
+            std::memcpy(&prev, rows[r] + w - 1, sizeof(V));
+            std::memcpy(&mid[r], rows[r] + w, sizeof(V));
+            std::memcpy(&next, rows[r] + w + 1, sizeof(V));
+            west[r] = (mid[r] << 1) | (prev >> 63);
+            east[r] = (mid[r] >> 1) | (next << 63);
+        }
+        V ones, twos, fours, eights, result;
+        neighbourCount(west[0], mid[0], east[0], west[1], east[1], west[2], mid[2], east[2], ones, twos, fours, eights);
+        Rule::apply(ones, twos, fours, eights, mid[1], rule, result);
+        std::memcpy(out + w, &result, sizeof(V));
+    }
+}
+
+template <class Rule>
+static void rowKernelRuleScalar(const uint64_t* above, const uint64_t* row, const uint64_t* below,
+                                uint64_t* out, int begin, int end, const LifeRule& rule) {
+    rowKernelRuleLoop<Rule, uint64_t>(above, row, below, out, begin, end, rule);
+}
+
+template <class Rule>
+static uint64_t ruleWord(uint64_t aW, uint64_t a, uint64_t aE, uint64_t bW, uint64_t b, uint64_t bE,
+                         uint64_t cW, uint64_t c, uint64_t cE, const LifeRule& rule) {
+    uint64_t ones, twos, fours, eights, result;
+    neighbourCount(aW, a, aE, bW, bE, cW, c, cE, ones, twos, fours, eights);
+    Rule::apply(ones, twos, fours, eights, b, rule, result);
+    return result;
+}
+
+static uint64_t lifeWordKernel(uint64_t aW, uint64_t a, uint64_t aE, uint64_t bW, uint64_t b, uint64_t bE,
+                               uint64_t cW, uint64_t c, uint64_t cE, const LifeRule&) {
+    return lifeWord(aW, a, aE, bW, b, bE, cW, c, cE);
+}
+
+#ifdef GOL_X86_SIMD
+// The same loop on GCC vector types, compiled for each instruction set
+typedef uint64_t Vec128 __attribute__((vector_size(16)));
+typedef uint64_t Vec256 __attribute__((vector_size(32)));
+typedef uint64_t Vec512 __attribute__((vector_size(64)));
+
+template <class Rule>
+__attribute__((target("sse2")))
+static void rowKernelRuleSSE2(const uint64_t* above, const uint64_t* row, const uint64_t* below,
+                              uint64_t* out, int begin, int end, const LifeRule& rule) {
+    rowKernelRuleLoop<Rule, Vec128>(above, row, below, out, begin, end, rule);
+    rowKernelRuleLoop<Rule, uint64_t>(above, row, below, out, begin, end, rule);
+}
+
+template <class Rule>
+__attribute__((target("avx2")))
+static void rowKernelRuleAVX2(const uint64_t* above, const uint64_t* row, const uint64_t* below,
+                              uint64_t* out, int begin, int end, const LifeRule& rule) {
+    rowKernelRuleLoop<Rule, Vec256>(above, row, below, out, begin, end, rule);
+    rowKernelRuleLoop<Rule, uint64_t>(above, row, below, out, begin, end, rule);
+}
+
+template <class Rule>
+__attribute__((target("avx512f")))
+static void rowKernelRuleAVX512(const uint64_t* above, const uint64_t* row, const uint64_t* below,
+                                uint64_t* out, int begin, int end, const LifeRule& rule) {
+    rowKernelRuleLoop<Rule, Vec512>(above, row, below, out, begin, end, rule);
+    rowKernelRuleLoop<Rule, uint64_t>(above, row, below, out, begin, end, rule);
+}
+#endif
+
+// Kernels resolved for one rule: rows go through the vectorized row kernel,
+// single words (row edges, sparse chunks) through the word kernel
+struct EvolveKernel {
+    RowKernel rowFn;
+    WordKernel wordFn;
+    LifeRule rule;
+
+    void row(const uint64_t* above, const uint64_t* current, const uint64_t* below,
+             uint64_t* out, int begin, int end) const {
+        rowFn(above, current, below, out, begin, end, rule);
+    }
+
+    uint64_t word(uint64_t aW, uint64_t a, uint64_t aE, uint64_t bW, uint64_t b, uint64_t bE,
+                  uint64_t cW, uint64_t c, uint64_t cE) const {
+        return wordFn(aW, a, aE, bW, b, bE, cW, c, cE, rule);
+    }
+};
+
+// Registry of packed evolve kernels with runtime CPU dispatch
+class KernelRegistry {
+public:
+    // Rules with kernels of their own; any other rule uses the dynamic one
+    enum RuleKind { LifeKind, HighLifeKind, DayNightKind, SeedsKind, DynamicKind, RuleKinds };
+
+    struct Kernel {
+        const char* name;
+        RowKernel fn[RuleKinds]; // Indexed by RuleKind
+        bool (*supported)();
+    };
+
+private:
+    static bool alwaysSupported() { return true; }
+
+#ifdef GOL_X86_SIMD
+    static bool cpuHasSSE2() { return __builtin_cpu_supports("sse2"); }
+    static bool cpuHasAVX2() { return __builtin_cpu_supports("avx2"); }
+    static bool cpuHasAVX512() { return __builtin_cpu_supports("avx512f"); }
+#endif
+
+    static const std::vector<Kernel>& kernels() {
+        // Ordered from most portable to fastest
+        static const std::vector<Kernel> list = {
+            { "scalar", { rowKernelScalar, rowKernelRuleScalar<HighLifeRule>, rowKernelRuleScalar<DayNightRule>,
+                          rowKernelRuleScalar<SeedsRule>, rowKernelRuleScalar<DynamicRule> }, alwaysSupported },
+#ifdef GOL_X86_SIMD
+            { "sse2", { rowKernelSSE2, rowKernelRuleSSE2<HighLifeRule>, rowKernelRuleSSE2<DayNightRule>,
+                        rowKernelRuleSSE2<SeedsRule>, rowKernelRuleSSE2<DynamicRule> }, cpuHasSSE2 },
+            { "avx2", { rowKernelAVX2, rowKernelRuleAVX2<HighLifeRule>, rowKernelRuleAVX2<DayNightRule>,
+                        rowKernelRuleAVX2<SeedsRule>, rowKernelRuleAVX2<DynamicRule> }, cpuHasAVX2 },
+            { "avx512", { rowKernelAVX512, rowKernelRuleAVX512<HighLifeRule>, rowKernelRuleAVX512<DayNightRule>,
+                          rowKernelRuleAVX512<SeedsRule>, rowKernelRuleAVX512<DynamicRule> }, cpuHasAVX512 },
+#endif
+        };
+        return list;
+    }
+
+    static const Kernel*& selected() {
+        static const Kernel* kernel = best();
+        return kernel;
+    }
+
+public:
+    // Fastest kernel supported by the CPU we are running on
+    static const Kernel* best() {
+        const Kernel* result = &kernels().front();
+        for (const Kernel& k : kernels()) {
+            if (k.supported()) result = &k;
+        }
+        return result;
+    }
+
+    static const Kernel& active() {
+        return *selected();
+    }
+
+    // Kernel kind of a rule (of the alive/dead part of a Generations rule).
+    // Worlds look it up when their rule changes rather than every step.
+    static RuleKind kindOf(const LifeRule& rule) {
+        auto named = [](const char* spec) {
+            LifeRule parsed;
+            LifeRule::parse(spec, parsed);
+            return parsed;
+        };
+        static const LifeRule highLife = named("B36/S23");
+        static const LifeRule dayNight = named("B3678/S34678");
+        static const LifeRule seeds = named("B2/S");
+        LifeRule binary = rule;
+        binary.states = 2;
+        if (binary.isLife()) return LifeKind;
+        if (binary == highLife) return HighLifeKind;
+        if (binary == dayNight) return DayNightKind;
+        if (binary == seeds) return SeedsKind;
+        return DynamicKind;
+    }
+
+    // Active kernel for a rule of the given kind (see kindOf)
+    static EvolveKernel resolve(RuleKind kind, const LifeRule& rule) {
+        static const WordKernel words[RuleKinds] = {
+            lifeWordKernel, ruleWord<HighLifeRule>, ruleWord<DayNightRule>, ruleWord<SeedsRule>, ruleWord<DynamicRule>
+        };
+        LifeRule binary = rule;
+        binary.states = 2;
+        return EvolveKernel{ active().fn[kind], words[kind], binary };
+    }
+
+    static EvolveKernel resolve(const LifeRule& rule) {
+        return resolve(kindOf(rule), rule);
+    }
+
+    // Force a kernel by name ("auto" restores CPU dispatch), returns false if
+    // the kernel is unknown or not supported by this CPU
+    static bool select(const std::string& name) {
+        if (name == "auto") {
+            selected() = best();
+            return true;
+        }
+        for (const Kernel& k : kernels()) {
+            if (name == k.name && k.supported()) {
+                selected() = &k;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Space separated list of kernels usable on this CPU
+    static std::string availableNames() {
+        std::string names;
+        for (const Kernel& k : kernels()) {
+            if (!k.supported()) continue;
+            if (!names.empty()) names += " ";
+            names += k.name;
+        }
+        return names;
+    }
+};
+
+// Evolve the words [begin, end) of a packed row. The first and last words of
+// the row need wrap-around handling and go through the generic path; the
+// interior is handed to the active (possibly vectorized) row kernel.
+static void evolvePackedRange(const uint64_t* above, const uint64_t* row, const uint64_t* below,
+                              uint64_t* out, int begin, int end, int nWords, int lastBits,
+                              uint64_t lastMask, const EvolveKernel& kernel) {
+    int edges[2] = { 0, nWords - 1 };
+    for (int i = 0; i < (nWords > 1 ? 2 : 1); i++) {
+        int w = edges[i];
+        if (w < begin || w >= end) continue;
+        uint64_t aW, aE, bW, bE, cW, cE;
+        horizontalNeighbors(above, w, nWords, lastBits, aW, aE);
+        horizontalNeighbors(row, w, nWords, lastBits, bW, bE);
+        horizontalNeighbors(below, w, nWords, lastBits, cW, cE);
+        out[w] = kernel.word(aW, above[w], aE, bW, row[w], bE, cW, below[w], cE);
+    }
+    int interiorBegin = std::max(begin, 1);
+    int interiorEnd = std::min(end, nWords - 1);
+    if (interiorEnd > interiorBegin) {
+        kernel.row(above, row, below, out, interiorBegin, interiorEnd);
+    }
+    if (end == nWords) {
+        out[nWords - 1] &= lastMask;
+    }
+}
+
+// Evolve a complete packed row
+static inline void evolvePackedRow(const uint64_t* above, const uint64_t* row, const uint64_t* below,
+                                   uint64_t* out, int nWords, int lastBits, uint64_t lastMask,
+                                   const EvolveKernel& kernel) {
+    evolvePackedRange(above, row, below, out, 0, nWords, nWords, lastBits, lastMask, kernel);
+}
+
+// GenerationMetrics - statistics of one generation, gathered while it is
+// evolved: live cells, births and deaths since the previous generation, the
+// live bounding box and the number of regions that changed or were evolved
+struct GenerationMetrics {
+    uint64_t generation = 0;
+    uint64_t population = 0;
+    uint64_t births = 0;
+    uint64_t deaths = 0;
+    int64_t minX = INT64_MAX; // Live bounding box, empty while minX > maxX
+    int64_t minY = INT64_MAX;
+    int64_t maxX = INT64_MIN;
+    int64_t maxY = INT64_MIN;
+    uint64_t active = 0;      // Changed rows (dense, packed), evolved tiles (tiled) or chunks (sparse)
+
+    // Grow the bounding box to cover columns [x0, x1] of rows [y0, y1]
+    void extend(int64_t x0, int64_t y0, int64_t x1, int64_t y1) {
+        minX = std::min(minX, x0);
+        minY = std::min(minY, y0);
+        maxX = std::max(maxX, x1);
+        maxY = std::max(maxY, y1);
+    }
+
+    // Grow the bounding box to rows [y0, y1] and the columns of the set bits
+    // of 'columns' (the OR of live words, word 0 starting at column x0)
+    void extendColumns(const uint64_t* columns, int count, int64_t x0, int64_t y0, int64_t y1) {
+        int first = 0, last = count - 1;
+        while (first < count && columns[first] == 0) first++;
+        if (first == count) return;
+        while (columns[last] == 0) last--;
+        extend(x0 + first * 64 + __builtin_ctzll(columns[first]), y0,
+               x0 + last * 64 + 63 - __builtin_clzll(columns[last]), y1);
+    }
+
+    // Add the counts of another part of the same generation
+    void merge(const GenerationMetrics& other) {
+        population += other.population;
+        births += other.births;
+        deaths += other.deaths;
+        active += other.active;
+        if (other.minX <= other.maxX) extend(other.minX, other.minY, other.maxX, other.maxY);
+    }
+};
+
+// Metrics kernel signature: add the live cells, births and deaths of words
+// [begin, end) of a row going from 'before' to 'after' to the per-lane sums
+// sums[0..7], sums[8..15] and sums[16..23] (see metricsSums), and OR the live
+// words into columns[begin, end). Returns 1 if the words have live cells,
+// plus 2 if any of them changed. Called on rows the evolve kernel just
+// wrote, while they are in cache; the lanes are only added up once per band.
+typedef int (*MetricsKernel)(const uint64_t* before, const uint64_t* after, int begin, int end,
+                             uint64_t* columns, uint64_t* sums);
+
+static constexpr int metricsLanes = 8;
+
+// Population, births and deaths from the per-lane sums of a metrics kernel
+static inline void metricsSums(const uint64_t* sums, GenerationMetrics& totals) {
+    for (int k = 0; k < metricsLanes; k++) {
+        totals.population += sums[k];
+        totals.births += sums[metricsLanes + k];
+        totals.deaths += sums[2 * metricsLanes + k];
+    }
+}
+
+static inline int rowMetricsLoop(const uint64_t* before, const uint64_t* after, int begin, int end,
+                                 uint64_t* columns, uint64_t* sums) {
+    uint64_t live = 0, born = 0, died = 0, any = 0, changed = 0;
+    for (int w = begin; w < end; w++) {
+        uint64_t a = before[w], b = after[w];
+        live += static_cast<uint64_t>(__builtin_popcountll(b));
+        born += static_cast<uint64_t>(__builtin_popcountll(b & ~a));
+        died += static_cast<uint64_t>(__builtin_popcountll(a & ~b));
+        any |= b;
+        changed |= a ^ b;
+        columns[w] |= b;
+    }
+    sums[0] += live;
+    sums[metricsLanes] += born;
+    sums[2 * metricsLanes] += died;
+    return (any != 0 ? 1 : 0) | (changed != 0 ? 2 : 0);
+}
+
+static int rowMetricsScalar(const uint64_t* before, const uint64_t* after, int begin, int end,
+                            uint64_t* columns, uint64_t* sums) {
+    return rowMetricsLoop(before, after, begin, end, columns, sums);
+}
+
+#ifdef GOL_X86_SIMD
+// The same loop with the POPCNT instruction instead of a bit-twiddling popcount
+__attribute__((target("popcnt")))
+static int rowMetricsPOPCNT(const uint64_t* before, const uint64_t* after, int begin, int end,
+                            uint64_t* columns, uint64_t* sums) {
+    return rowMetricsLoop(before, after, begin, end, columns, sums);
+}
+
+// Bit counts of the four words of v: per-nibble table lookups, summed per word
+__attribute__((target("avx2")))
+static inline __m256i popcountAVX2(__m256i v) {
+    const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                           0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low = _mm256_set1_epi8(0x0F);
+    __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(table, _mm256_and_si256(v, low)),
+                                    _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), low)));
+    return _mm256_sad_epu8(bytes, _mm256_setzero_si256());
+}
+
+// AVX2 kernel, four words per iteration (lanes 0..3 of each sum)
+__attribute__((target("avx2,popcnt")))
+static int rowMetricsAVX2(const uint64_t* before, const uint64_t* after, int begin, int end,
+                          uint64_t* columns, uint64_t* sums) {
+    __m256i* lanes[3] = { reinterpret_cast<__m256i*>(sums), reinterpret_cast<__m256i*>(sums + metricsLanes),
+                          reinterpret_cast<__m256i*>(sums + 2 * metricsLanes) };
+    __m256i live = _mm256_loadu_si256(lanes[0]), born = _mm256_loadu_si256(lanes[1]);
+    __m256i died = _mm256_loadu_si256(lanes[2]);
+    __m256i any = _mm256_setzero_si256(), changed = any;
+    int w = begin;
+    for (; w + 4 <= end; w += 4) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(before + w));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(after + w));
+        __m256i diff = _mm256_xor_si256(a, b);
+        live = _mm256_add_epi64(live, popcountAVX2(b));
+        born = _mm256_add_epi64(born, popcountAVX2(_mm256_and_si256(diff, b)));
+        died = _mm256_add_epi64(died, popcountAVX2(_mm256_and_si256(diff, a)));
+        any = _mm256_or_si256(any, b);
+        changed = _mm256_or_si256(changed, diff);
+        __m256i* column = reinterpret_cast<__m256i*>(columns + w);
+        _mm256_storeu_si256(column, _mm256_or_si256(_mm256_loadu_si256(column), b));
+    }
+    _mm256_storeu_si256(lanes[0], live);
+    _mm256_storeu_si256(lanes[1], born);
+    _mm256_storeu_si256(lanes[2], died);
+    int flags = (_mm256_testz_si256(any, any) ? 0 : 1) | (_mm256_testz_si256(changed, changed) ? 0 : 2);
+    return flags | rowMetricsLoop(before, after, w, end, columns, sums);
+}
+
+// AVX-512 kernel with the per-word VPOPCNTQ instruction, eight words per iteration
+__attribute__((target("avx512f,avx512vpopcntdq,popcnt")))
+static int rowMetricsAVX512(const uint64_t* before, const uint64_t* after, int begin, int end,
+                            uint64_t* columns, uint64_t* sums) {
+    __m512i live = _mm512_loadu_si512(sums), born = _mm512_loadu_si512(sums + metricsLanes);
+    __m512i died = _mm512_loadu_si512(sums + 2 * metricsLanes);
+    __m512i any = _mm512_setzero_si512(), changed = any;
+    int w = begin;
+    for (; w + 8 <= end; w += 8) {
+        __m512i a = _mm512_loadu_si512(before + w);
+        __m512i b = _mm512_loadu_si512(after + w);
+        __m512i diff = _mm512_xor_si512(a, b);
+        live = _mm512_add_epi64(live, _mm512_popcnt_epi64(b));
+        born = _mm512_add_epi64(born, _mm512_popcnt_epi64(_mm512_and_si512(diff, b)));
+        died = _mm512_add_epi64(died, _mm512_popcnt_epi64(_mm512_and_si512(diff, a)));
+        any = _mm512_or_si512(any, b);
+        changed = _mm512_or_si512(changed, diff);
+        _mm512_storeu_si512(columns + w, _mm512_or_si512(_mm512_loadu_si512(columns + w), b));
+    }
+    _mm512_storeu_si512(sums, live);
+    _mm512_storeu_si512(sums + metricsLanes, born);
+    _mm512_storeu_si512(sums + 2 * metricsLanes, died);
+    int flags = (_mm512_test_epi64_mask(any, any) ? 1 : 0) | (_mm512_test_epi64_mask(changed, changed) ? 2 : 0);
+    return flags | rowMetricsLoop(before, after, w, end, columns, sums);
+}
+#endif
+
+// Fastest metrics kernel supported by the CPU we are running on
+static MetricsKernel metricsKernel() {
+#ifdef GOL_X86_SIMD
+    static const MetricsKernel kernel =
+        __builtin_cpu_supports("avx512vpopcntdq") ? rowMetricsAVX512
+        : __builtin_cpu_supports("avx2") ? rowMetricsAVX2
+        : __builtin_cpu_supports("popcnt") ? rowMetricsPOPCNT : rowMetricsScalar;
+#else
+    static const MetricsKernel kernel = rowMetricsScalar;
+#endif
+    return kernel;
+}
+
+// StateHash - 128-bit hash of a world state
+// Each row (block of words) is hashed with two independent multiplicative
+// rolling hashes, and the row hashes are mixed with the row index and summed.
+// The sum lets every thread hash the rows it just produced and combine the
+// partial results in any order, so hashing is fused into the evolve pass.
+struct StateHash {
+    uint64_t lo;
+    uint64_t hi;
+
+    StateHash() : lo(0), hi(0) {}
+
+    StateHash& operator+=(const StateHash& other) {
+        lo += other.lo;
+        hi += other.hi;
+        return *this;
+    }
+
+    bool operator==(const StateHash& other) const {
+        return lo == other.lo && hi == other.hi;
+    }
+};
+
+struct StateHashHasher {
+    size_t operator()(const StateHash& h) const {
+        return static_cast<size_t>(h.lo ^ (h.hi >> 7));
+    }
+};
+
+static inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// Philox4x32-10 counter-based generator (Salmon et al., "Parallel random
+// numbers: as easy as 1, 2, 3"): ten multiply-xor rounds turn the 128-bit
+// counter (c0..c3) into four random words under a 64-bit key. Any element of
+// a stream is computed directly from its counter, so parallel loops draw the
+// same numbers whichever thread handles each element.
+static inline std::array<uint32_t, 4> philox4x32(uint32_t c0, uint32_t c1, uint32_t c2, uint32_t c3, uint64_t key) {
+    uint32_t k0 = static_cast<uint32_t>(key);
+    uint32_t k1 = static_cast<uint32_t>(key >> 32);
+    for (int round = 0; round < 10; round++) {
+        uint64_t p0 = static_cast<uint64_t>(0xD2511F53u) * c0;
+        uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57u) * c2;
+        c0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+        c1 = static_cast<uint32_t>(p1);
+        c2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+        c3 = static_cast<uint32_t>(p0);
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+    }
+    return {{ c0, c1, c2, c3 }};
+}
+
+// Hash contribution of a block of words (a row) at the given block index.
+// Empty blocks contribute nothing, so an empty world hashes to zero.
+// Words are spread over four independent lanes so the multiply chains overlap.
+static inline StateHash blockHash(const uint64_t* words, int count, uint64_t blockIndex) {
+    uint64_t lo[4] = { 1, 2, 3, 4 };
+    uint64_t hi[4] = { 5, 6, 7, 8 };
+    uint64_t any = 0;
+    int w = 0;
+    for (; w + 4 <= count; w += 4) {
+        for (int k = 0; k < 4; k++) {
+            lo[k] = (lo[k] ^ words[w + k]) * 0x9E3779B97F4A7C15ULL;
+            hi[k] = ((hi[k] << 23) | (hi[k] >> 41)) + words[w + k];
+            any |= words[w + k];
+        }
+    }
+    for (; w < count; w++) {
+        lo[0] = (lo[0] ^ words[w]) * 0x9E3779B97F4A7C15ULL;
+        hi[0] = ((hi[0] << 23) | (hi[0] >> 41)) + words[w];
+        any |= words[w];
+    }
+    StateHash h;
+    if (any != 0) {
+        h.lo = mix64(mix64(lo[0] ^ (blockIndex * 0xC2B2AE3D27D4EB4FULL)) + lo[1] * 3 + lo[2] * 5 + lo[3] * 7);
+        h.hi = mix64(mix64(hi[0] + blockIndex * 0x165667B19E3779F9ULL) ^ mix64(hi[1] + hi[2] * 3 + hi[3] * 5));
+    }
+    return h;
+}
+
+// StateHistory - the recent state hashes of a run for cycle detection, oldest
+// first, with a lookup of the latest generation at which a hash was seen.
+// Entries live in a ring and are indexed by an open-addressing table, so
+// recording a generation and dropping old ones reuse the same storage; both
+// only grow when the window of kept generations does.
+class StateHistory {
+public:
+    typedef std::pair<StateHash, uint64_t> Entry; // Hash and generation
+
+private:
+    std::vector<Entry> entries; // Ring of recorded states
+    std::vector<uint32_t> index; // Ring slot + 1 of the latest entry of a hash, 0 if empty
+    size_t head;                 // Slot of the oldest entry
+    size_t count;
+
+    size_t home(const StateHash& hash) const {
+        return static_cast<size_t>(mix64(hash.lo ^ hash.hi)) & (index.size() - 1);
+    }
+
+    // Position in the index of a hash, or of the empty place it would take
+    size_t locate(const StateHash& hash) const {
+        size_t i = home(hash);
+        while (index[i] && !(entries[index[i] - 1].first == hash)) {
+            i = (i + 1) & (index.size() - 1);
+        }
+        return i;
+    }
+
+    // Empty index position i, moving later entries of its probe run back
+    // so every remaining hash is still found (linear probing deletion)
+    void unindex(size_t i) {
+        size_t mask = index.size() - 1;
+        for (size_t j = (i + 1) & mask; index[j]; j = (j + 1) & mask) {
+            size_t h = home(entries[index[j] - 1].first);
+            bool between = (i <= j) ? (i < h && h <= j) : (i < h || h <= j);
+            if (between) continue;
+            index[i] = index[j];
+            i = j;
+        }
+        index[i] = 0;
+    }
+
+    // Double the ring (and its index), keeping the entries in order
+    void grow() {
+        std::vector<Entry> ordered(std::max<size_t>(64, entries.size() * 2));
+        for (size_t k = 0; k < count; k++) {
+            ordered[k] = entries[(head + k) % entries.size()];
+        }
+        entries.swap(ordered);
+        head = 0;
+        index.assign(entries.size() * 2, 0);
+        for (size_t k = 0; k < count; k++) {
+            index[locate(entries[k].first)] = static_cast<uint32_t>(k + 1);
+        }
+    }
+
+public:
+    StateHistory() : head(0), count(0) {}
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+
+    void clear() {
+        head = 0;
+        count = 0;
+        std::fill(index.begin(), index.end(), 0);
+    }
+
+    // Latest generation at which the hash was recorded, false if none is kept
+    bool find(const StateHash& hash, uint64_t& generation) const {
+        if (count == 0) return false;
+        size_t i = locate(hash);
+        if (!index[i]) return false;
+        generation = entries[index[i] - 1].second;
+        return true;
+    }
+
+    // Record the state of a generation and drop the states more than
+    // 'window' generations older than it
+    void record(const StateHash& hash, uint64_t generation, uint64_t window) {
+        if (count == entries.size()) grow();
+        size_t slot = (head + count) % entries.size();
+        entries[slot] = Entry(hash, generation);
+        count++;
+        index[locate(hash)] = static_cast<uint32_t>(slot + 1);
+
+        while (count > 0 && generation - entries[head].second > window) {
+            size_t i = locate(entries[head].first);
+            if (index[i] == head + 1) unindex(i); // Not superseded by a later entry of the same hash
+            head = (head + 1) % entries.size();
+            count--;
+        }
+    }
+
+    // Call f(entry) for every kept entry, oldest first
+    template <class F>
+    void forEach(F f) const {
+        for (size_t k = 0; k < count; k++) {
+            f(entries[(head + k) % entries.size()]);
+        }
+    }
+};
+
+// SparseGrid class - unbounded plane stored as a hash map of 64x64 chunks
+// Chunks are allocated when a cell in them comes alive and dropped when they
+// become empty, so memory scales with the live population rather than with
+// the bounding box. Chunk (cx, cy) covers cells [cx*64, cx*64+64) x
+// [cy*64, cy*64+64); word r of a chunk is row r, bit i is column i.
+class SparseGrid {
+public:
+    static constexpr int chunkShift = 6;
+    static constexpr int chunkSize = 1 << chunkShift;
+
+    struct ChunkKey {
+        int64_t x;
+        int64_t y;
+
+        bool operator==(const ChunkKey& other) const {
+            return x == other.x && y == other.y;
+        }
+    };
+
+    struct ChunkKeyHasher {
+        size_t operator()(const ChunkKey& key) const {
+            return static_cast<size_t>(mix64(static_cast<uint64_t>(key.x) * 0x9E3779B97F4A7C15ULL +
+                                             static_cast<uint64_t>(key.y)));
+        }
+    };
+
+    typedef std::array<uint64_t, chunkSize> Chunk;
+    typedef std::unordered_map<ChunkKey, Chunk, ChunkKeyHasher> ChunkMap;
+
+private:
+    ChunkMap chunks; // Non-empty chunks only
+
+public:
+    // Chunk containing a cell (arithmetic shift rounds towards -infinity)
+    static ChunkKey keyFor(int64_t x, int64_t y) {
+        return ChunkKey{ x >> chunkShift, y >> chunkShift };
+    }
+
+    bool get(int64_t x, int64_t y) const {
+        auto it = chunks.find(keyFor(x, y));
+        if (it == chunks.end()) return false;
+        return (it->second[y & (chunkSize - 1)] >> (x & (chunkSize - 1))) & 1;
+    }
+
+    void set(int64_t x, int64_t y, bool state) {
+        ChunkKey key = keyFor(x, y);
+        uint64_t bit = 1ULL << (x & (chunkSize - 1));
+        int row = static_cast<int>(y & (chunkSize - 1));
+        if (state) {
+            auto it = chunks.find(key);
+            if (it == chunks.end()) {
+                it = chunks.emplace(key, Chunk()).first;
+                it->second.fill(0);
+            }
+            it->second[row] |= bit;
+            return;
+        }
+        auto it = chunks.find(key);
+        if (it == chunks.end()) return;
+        it->second[row] &= ~bit;
+        if (isEmpty(it->second)) {
+            chunks.erase(it); // Free chunks as soon as they are empty
+        }
+    }
+
+    const Chunk* find(const ChunkKey& key) const {
+        auto it = chunks.find(key);
+        return it == chunks.end() ? nullptr : &it->second;
+    }
+
+    // Overwrite the cells of word 'wordX' (columns wordX * 64 ..) of row y
+    // selected by mask with the matching bits of 'bits'
+    void setWord(int64_t wordX, int64_t y, uint64_t mask, uint64_t bits) {
+        ChunkKey key{ wordX, y >> chunkShift };
+        int row = static_cast<int>(y & (chunkSize - 1));
+        auto it = chunks.find(key);
+        if (it == chunks.end()) {
+            if ((bits & mask) == 0) return;
+            it = chunks.emplace(key, Chunk()).first;
+            it->second.fill(0);
+        }
+        it->second[row] = (it->second[row] & ~mask) | (bits & mask);
+        if (isEmpty(it->second)) {
+            chunks.erase(it);
+        }
+    }
+
+    // Store a computed chunk (callers never insert empty chunks)
+    void insert(const ChunkKey& key, const Chunk& chunk) {
+        chunks[key] = chunk;
+    }
+
+    const ChunkMap& getChunks() const { return chunks; }
+    size_t chunkCount() const { return chunks.size(); }
+    void clear() { chunks.clear(); }
+
+    static bool isEmpty(const Chunk& chunk) {
+        uint64_t any = 0;
+        for (uint64_t word : chunk) any |= word;
+        return any == 0;
+    }
+
+    bool operator==(const SparseGrid& other) const {
+        return chunks == other.chunks;
+    }
+};
+
+// Evolve one chunk of a sparse grid. neighbours[dy + 1][dx + 1] is the chunk
+// at offset (dx, dy), null where no chunk is allocated (all dead).
+static void evolveSparseChunk(const SparseGrid::Chunk* neighbours[3][3], SparseGrid::Chunk& out,
+                              const EvolveKernel& kernel) {
+    const int size = SparseGrid::chunkSize;
+    // West/middle/east neighbour words for rows -1..64 of the chunk
+    uint64_t west[size + 2], mid[size + 2], east[size + 2];
+    for (int r = -1; r <= size; r++) {
+        int band = (r < 0) ? 0 : (r >= size ? 2 : 1);
+        int rr = (r + size) & (size - 1);
+        uint64_t w = neighbours[band][0] ? (*neighbours[band][0])[rr] : 0;
+        uint64_t m = neighbours[band][1] ? (*neighbours[band][1])[rr] : 0;
+        uint64_t e = neighbours[band][2] ? (*neighbours[band][2])[rr] : 0;
+        west[r + 1] = (m << 1) | (w >> 63);
+        mid[r + 1] = m;
+        east[r + 1] = (m >> 1) | (e << 63);
+    }
+    if (kernel.rule.isLife()) {
+        for (int r = 0; r < size; r++) {
+            out[r] = lifeWord(west[r], mid[r], east[r],
+                              west[r + 1], mid[r + 1], east[r + 1],
+                              west[r + 2], mid[r + 2], east[r + 2]);
+        }
+        return;
+    }
+    for (int r = 0; r < size; r++) {
+        out[r] = kernel.word(west[r], mid[r], east[r],
+                             west[r + 1], mid[r + 1], east[r + 1],
+                             west[r + 2], mid[r + 2], east[r + 2]);
+    }
+}
+
+// GenerationRing class - fixed ring of preallocated generation buffers
+// Slot head holds the current generation and the slot after it the oldest one,
+// so an evolve step writes the new generation over the oldest buffer and then
+// advances head. Stepping a generation never copies or allocates a grid.
+template <typename Grid>
+class GenerationRing {
+private:
+    std::vector<Grid> slots; // Generation buffers
+    std::vector<char> lent;  // Slots whose generation was exchanged away
+    size_t head;             // Slot holding the current generation
+    size_t filled;           // Number of slots holding a valid generation
+
+    size_t slotIndex(size_t age) const {
+        return (head + slots.size() - age) % slots.size();
+    }
+
+public:
+    GenerationRing() : head(0), filled(0) {}
+
+    // Allocate all slots up front, the current generation starts as initial
+    void reset(size_t capacity, const Grid& initial) {
+        slots.assign(capacity, initial);
+        lent.assign(capacity, 0);
+        head = 0;
+        filled = 1;
+    }
+
+    Grid& current() { return slots[head]; }
+    const Grid& current() const { return slots[head]; }
+
+    // Buffer the next generation is written to (the oldest stored generation)
+    Grid& next() { return slots[(head + 1) % slots.size()]; }
+
+    // Make the buffer returned by next() the current generation
+    void advance() {
+        head = (head + 1) % slots.size();
+        lent[head] = 0;
+        if (filled < slots.size()) filled++;
+    }
+
+    // Generation stored 'age' steps before the current one (0 = current)
+    const Grid& back(size_t age) const {
+        return slots[slotIndex(age)];
+    }
+
+    // Number of generations available through back()
+    size_t size() const { return filled; }
+
+    // Whether back(age) still holds its generation
+    bool has(size_t age) const {
+        return age < filled && !lent[slotIndex(age)];
+    }
+
+    // Whether the buffer returned by next() still holds its old generation
+    bool nextIntact() const {
+        return !lent[(head + 1) % slots.size()];
+    }
+
+    // Swap the buffer of an older generation (age >= 1) with 'buffer' in
+    // O(1), e.g. to hand it to a background writer. The slot is marked as
+    // lent until it is reused for a new generation; buffer must have the
+    // same dimensions since the ring will evolve into it later.
+    void exchange(size_t age, Grid& buffer) {
+        std::swap(slots[slotIndex(age)], buffer);
+        lent[slotIndex(age)] = 1;
+    }
+
+    // Apply fn to every slot, e.g. to re-place their memory
+    template<typename Fn>
+    void forEachSlot(Fn fn) {
+        for (Grid& grid : slots) fn(grid);
+    }
+};
+
+// MappedFile class - read-only view of a whole file
+// Uses mmap where available so loading touches only the pages it reads;
+// elsewhere the file is read into memory.
+class MappedFile {
+private:
+    const uint8_t* bytes;
+    size_t length;
+    bool mapped;
+    std::vector<uint8_t> buffer; // Fallback storage when the file is not mapped
+
+public:
+    MappedFile() : bytes(nullptr), length(0), mapped(false) {}
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        close();
+    }
+
+    void close() {
+#ifdef GOL_HAVE_MMAP
+        if (mapped) munmap(const_cast<uint8_t*>(bytes), length);
+#endif
+        bytes = nullptr;
+        length = 0;
+        mapped = false;
+        buffer.clear();
+    }
+
+    bool open(const std::string& filename) {
+        close();
+#ifdef GOL_HAVE_MMAP
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* address = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (address != MAP_FAILED) {
+                bytes = static_cast<const uint8_t*>(address);
+                length = static_cast<size_t>(info.st_size);
+                mapped = true;
+                madvise(address, length, MADV_SEQUENTIAL);
+            }
+        }
+        ::close(fd);
+        if (mapped) return true;
+#endif
+        std::ifstream file(filename, std::ios::binary);
+        if (!file.is_open()) return false;
+        buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        bytes = buffer.data();
+        length = buffer.size();
+        return true;
+    }
+
+    const uint8_t* data() const { return bytes; }
+    size_t size() const { return length; }
+};
+
+// Binary world file format
+// A 40-byte header followed by the packed rows of the world in BitGrid layout
+// (64-bit little-endian words, bit i of word w is cell x = w * 64 + i). The
+// rows are written in blocks of rowsPerBlock rows. Uncompressed blocks are
+// the raw words; RLE blocks are a word count followed by that many token
+// words: a token with the top bit set is a run of zero words of the length in
+// its low bits, otherwise it is a count of literal words that follow it.
+struct BinaryWorldHeader {
+    char magic[8];         // binaryWorldMagic
+    uint32_t version;      // Format version (1)
+    uint32_t flags;        // binaryWorldRLE if blocks are run-length encoded
+    uint32_t width;        // World width in cells
+    uint32_t height;       // World height in cells
+    uint32_t storage;      // GameOfLife::Storage the world was saved from
+    uint32_t rowsPerBlock; // Rows per encoded block
+    uint64_t generation;   // Generation counter of the saved state
+};
+
+static const char binaryWorldMagic[8] = { 'G', 'O', 'L', 'B', 'I', 'N', '\r', '\n' };
+static constexpr uint32_t binaryWorldRLE = 1;
+static constexpr uint64_t rleZeroRun = 1ULL << 63;
+
+// Append the RLE encoding of 'count' words to 'out'
+static void encodeWordsRLE(const uint64_t* words, size_t count, std::vector<uint64_t>& out) {
+    size_t i = 0;
+    while (i < count) {
+        size_t zeros = 0;
+        while (i + zeros < count && words[i + zeros] == 0) zeros++;
+        if (zeros >= 2) {
+            out.push_back(rleZeroRun | zeros);
+            i += zeros;
+            continue;
+        }
+        // Literal run up to the next pair of zero words
+        size_t start = i;
+        while (i < count && !(words[i] == 0 && i + 1 < count && words[i + 1] == 0)) i++;
+        if (i == start) i++; // A lone trailing zero word
+        out.push_back(i - start);
+        out.insert(out.end(), words + start, words + i);
+    }
+}
+
+// Word offset (after the header) of each row block of a binary world file
+// with a valid header; the last entry is the end of the rows. Returns false
+// if the file is truncated.
+static bool binaryBlockOffsets(const BinaryWorldHeader& header, const uint64_t* data, size_t available,
+                               std::vector<size_t>& offsets) {
+    size_t nWords = (header.width + 63) / 64;
+    size_t rowsPerBlock = std::min(header.rowsPerBlock, header.height);
+    size_t blocks = (header.height + rowsPerBlock - 1) / rowsPerBlock;
+    offsets.assign(blocks + 1, 0);
+    for (size_t b = 0; b < blocks; b++) {
+        size_t rows = std::min<size_t>(rowsPerBlock, header.height - b * rowsPerBlock);
+        size_t blockWords = rows * nWords;
+        if (header.flags & binaryWorldRLE) {
+            if (offsets[b] >= available) return false;
+            blockWords = 1 + data[offsets[b]];
+        }
+        offsets[b + 1] = offsets[b] + blockWords;
+        if (offsets[b + 1] > available || offsets[b + 1] < offsets[b]) return false;
+    }
+    return true;
+}
+
+// Decode 'tokenCount' RLE token words into exactly 'count' words, returns
+// false if the tokens are malformed
+static bool decodeWordsRLE(const uint64_t* tokens, size_t tokenCount, uint64_t* out, size_t count) {
+    size_t written = 0;
+    size_t t = 0;
+    while (t < tokenCount) {
+        uint64_t token = tokens[t++];
+        uint64_t length = token & ~rleZeroRun;
+        if (length > count - written) return false;
+        if (token & rleZeroRun) {
+            std::fill(out + written, out + written + length, 0);
+        } else {
+            if (length > tokenCount - t) return false;
+            std::copy(tokens + t, tokens + t + length, out + written);
+            t += length;
+        }
+        written += length;
+    }
+    return written == count;
+}
+
+// GameOfLife class - handles the game logic and world state
+class GameOfLife {
+public:
+    // Grid storage backend, selected when the world is created
+    enum class Storage {
+        Dense,  // Nested vector<bool> rows, one cell per proxy bit
+        Packed, // Bit-packed 64-bit word rows with the SWAR evolve kernel
+        Tiled,  // Packed rows, only recomputing tiles near last generation's changes
+        Sparse  // Unbounded plane of 64x64 chunks; width x height is only the view
+    };
+
+    // Parse a storage backend name, returns false if the name is unknown
+    static bool parseStorage(const std::string& name, Storage& storage) {
+        if (name == "dense") {
+            storage = Storage::Dense;
+        } else if (name == "packed") {
+            storage = Storage::Packed;
+        } else if (name == "tiled") {
+            storage = Storage::Tiled;
+        } else if (name == "sparse") {
+            storage = Storage::Sparse;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    // Fill out[] with packed rows [y0, y1) (BitGrid layout) of a grid held
+    // in one of the storage formats; only the grid matching 'storage' is read
+    static void packGridRows(Storage storage, int width, const std::vector<std::vector<bool>>& dense,
+                             const BitGrid& packed, const SparseGrid& sparse, int y0, int y1, uint64_t* out) {
+        int nWords = (width + 63) / 64;
+        if (storage == Storage::Packed || storage == Storage::Tiled) {
+            std::copy(packed.row(y0), packed.row(y0) + static_cast<size_t>(y1 - y0) * nWords, out);
+            return;
+        }
+        uint64_t lastMask = (width % 64 == 0) ? ~0ULL : ((1ULL << (width % 64)) - 1);
+        #pragma omp parallel for schedule(static)
+        for (int y = y0; y < y1; y++) {
+            uint64_t* row = out + static_cast<size_t>(y - y0) * nWords;
+            if (storage == Storage::Sparse) {
+                // A 64-cell word of the view is one row of one chunk
+                for (int w = 0; w < nWords; w++) {
+                    const SparseGrid::Chunk* chunk = sparse.find(SparseGrid::ChunkKey{ w, y >> SparseGrid::chunkShift });
+                    row[w] = chunk ? (*chunk)[y & (SparseGrid::chunkSize - 1)] : 0;
+                }
+                row[nWords - 1] &= lastMask;
+                continue;
+            }
+            const std::vector<bool>& cells = dense[y];
+            std::fill(row, row + nWords, 0);
+            for (int x = 0; x < width; x++) {
+                if (cells[x]) row[x >> 6] |= 1ULL << (x & 63);
+            }
+        }
+    }
+
+    // Fill out[0..count) with the words [firstWord, firstWord + count) of row y
+    // of a grid held in one of the storage formats. Words outside a bounded
+    // grid read as zero; sparse grids have words at any 64-bit position.
+    static void gridRowWords(Storage storage, int width, int height, const std::vector<std::vector<bool>>& dense,
+                             const BitGrid& packed, const SparseGrid& sparse, int64_t y, int64_t firstWord,
+                             int count, uint64_t* out) {
+        std::fill(out, out + count, 0);
+        if (storage == Storage::Sparse) {
+            for (int i = 0; i < count; i++) {
+                const SparseGrid::Chunk* chunk = sparse.find(SparseGrid::ChunkKey{ firstWord + i, y >> SparseGrid::chunkShift });
+                if (chunk) out[i] = (*chunk)[y & (SparseGrid::chunkSize - 1)];
+            }
+            return;
+        }
+        if (y < 0 || y >= height) return;
+        int nWords = (width + 63) / 64;
+        int64_t begin = std::max<int64_t>(firstWord, 0);
+        int64_t end = std::min<int64_t>(firstWord + count, nWords);
+        if (begin >= end) return;
+        if (storage != Storage::Dense) {
+            const uint64_t* row = packed.row(static_cast<int>(y));
+            std::copy(row + begin, row + end, out + (begin - firstWord));
+            return;
+        }
+        const std::vector<bool>& cells = dense[y];
+        for (int64_t x = begin * 64; x < std::min<int64_t>(end * 64, width); x++) {
+            if (cells[x]) out[(x >> 6) - firstWord] |= 1ULL << (x & 63);
+        }
+    }
+
+    // Copy the w x h region with its top-left cell at (x, y) into out[] as
+    // packed rows of (w + 63) / 64 words: bit i of word k of a row is column
+    // x + 64k + i. rowWords(y, firstWord, count, words) reads word-aligned
+    // pieces of a row (see gridRowWords); each row is read once and shifted
+    // into place, and large regions are read by all threads.
+    template <class RowWords>
+    static void readRegion(const RowWords& rowWords, int64_t x, int64_t y, int w, int h, uint64_t* out) {
+        if (w <= 0 || h <= 0) return;
+        int outWords = (w + 63) / 64;
+        int shift = static_cast<int>(x & 63);
+        int64_t firstWord = x >> 6;
+        uint64_t lastMask = (w % 64 == 0) ? ~0ULL : ((1ULL << (w % 64)) - 1);
+        bool parallel = static_cast<int64_t>(w) * h >= regionParallelCells;
+        #pragma omp parallel if (parallel)
+        {
+            std::vector<uint64_t> words(outWords + 1);
+            #pragma omp for schedule(static)
+            for (int r = 0; r < h; r++) {
+                rowWords(y + r, firstWord, outWords + 1, words.data());
+                uint64_t* row = out + static_cast<size_t>(r) * outWords;
+                for (int k = 0; k < outWords; k++) {
+                    row[k] = shift ? (words[k] >> shift) | (words[k + 1] << (64 - shift)) : words[k];
+                }
+                row[outWords - 1] &= lastMask;
+            }
+        }
+    }
+
+    // A generation taken out of the world for checkpointing: its grid (in
+    // the member matching 'storage') plus the cycle-detection history up to it
+    struct Snapshot {
+        Storage storage = Storage::Dense;
+        int width = 0;
+        int height = 0;
+        uint64_t generation = 0;
+        int maxCyclePeriod = 0;
+        std::vector<std::pair<StateHash, uint64_t>> history; // (state hash, generation), oldest first
+        std::vector<std::vector<bool>> dense;
+        BitGrid packed;
+        SparseGrid sparse;
+
+        void packRows(int y0, int y1, uint64_t* out) const {
+            packGridRows(storage, width, dense, packed, sparse, y0, y1, out);
+        }
+
+        // Bulk read of a region of the snapshot (see GameOfLife::getRegion)
+        void getRegion(int64_t x, int64_t y, int w, int h, uint64_t* out) const {
+            readRegion([this](int64_t row, int64_t firstWord, int count, uint64_t* words) {
+                gridRowWords(storage, width, height, dense, packed, sparse, row, firstWord, count, words);
+            }, x, y, w, h, out);
+        }
+    };
+
+    // Write a world in the binary format (see BinaryWorldHeader), streamed one
+    // block of rows at a time from packRows. A non-null history is appended
+    // as a checkpoint trailer.
+    static bool writeBinaryWorld(const std::string& filename, bool compress, Storage storage, int width, int height,
+                                 uint64_t generation, const std::function<void(int, int, uint64_t*)>& packRows,
+                                 const Snapshot* history) {
+        std::ofstream file(filename, std::ios::binary);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not open file " << filename << std::endl;
+            return false;
+        }
+
+        BinaryWorldHeader header;
+        std::memcpy(header.magic, binaryWorldMagic, sizeof(header.magic));
+        header.version = 1;
+        header.flags = compress ? binaryWorldRLE : 0;
+        header.width = static_cast<uint32_t>(width);
+        header.height = static_cast<uint32_t>(height);
+        header.storage = static_cast<uint32_t>(storage);
+        header.rowsPerBlock = binaryRowsPerBlock;
+        header.generation = generation;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        int nWords = (width + 63) / 64;
+        std::vector<uint64_t> block(static_cast<size_t>(binaryRowsPerBlock) * nWords);
+        std::vector<uint64_t> encoded;
+        for (int y0 = 0; y0 < height; y0 += binaryRowsPerBlock) {
+            int rows = std::min(binaryRowsPerBlock, height - y0);
+            size_t count = static_cast<size_t>(rows) * nWords;
+            packRows(y0, y0 + rows, block.data());
+            if (compress) {
+                encoded.assign(1, 0);
+                encodeWordsRLE(block.data(), count, encoded);
+                encoded[0] = encoded.size() - 1;
+                file.write(reinterpret_cast<const char*>(encoded.data()), encoded.size() * sizeof(uint64_t));
+            } else {
+                file.write(reinterpret_cast<const char*>(block.data()), count * sizeof(uint64_t));
+            }
+        }
+
+        if (history) {
+            // Checkpoint trailer: magic, period limit, entry count, (lo, hi, generation) entries
+            file.write(checkpointMagic, sizeof(checkpointMagic));
+            uint32_t counts[2] = { static_cast<uint32_t>(history->maxCyclePeriod),
+                                   static_cast<uint32_t>(history->history.size()) };
+            file.write(reinterpret_cast<const char*>(counts), sizeof(counts));
+            for (const auto& entry : history->history) {
+                uint64_t words[3] = { entry.first.lo, entry.first.hi, entry.second };
+                file.write(reinterpret_cast<const char*>(words), sizeof(words));
+            }
+            // Sparse worlds extend past the view: append every chunk as (x, y, rows)
+            uint64_t chunkCount = history->sparse.getChunks().size();
+            file.write(reinterpret_cast<const char*>(&chunkCount), sizeof(chunkCount));
+            for (const auto& entry : history->sparse.getChunks()) {
+                int64_t key[2] = { entry.first.x, entry.first.y };
+                file.write(reinterpret_cast<const char*>(key), sizeof(key));
+                file.write(reinterpret_cast<const char*>(entry.second.data()), sizeof(SparseGrid::Chunk));
+            }
+        }
+
+        file.close();
+        if (!file.good()) {
+            std::cerr << "Error: Could not write file " << filename << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Write a snapshot as a checkpoint: a binary world file with history
+    static bool writeCheckpoint(const Snapshot& snapshot, const std::string& filename) {
+        return writeBinaryWorld(filename, true, snapshot.storage, snapshot.width, snapshot.height, snapshot.generation,
+                                [&snapshot](int y0, int y1, uint64_t* out) { snapshot.packRows(y0, y1, out); },
+                                &snapshot);
+    }
+
+    static const char* storageName(Storage storage) {
+        switch (storage) {
+            case Storage::Packed: return "packed";
+            case Storage::Tiled: return "tiled";
+            case Storage::Sparse: return "sparse";
+            default: return "dense";
+        }
+    }
+
+private:
+    int width;                  // Width of the grid
+    int height;                 // Height of the grid
+    Storage storage;            // Storage backend in use
+    LifeRule rule;              // Rule the world evolves by
+    KernelRegistry::RuleKind ruleKind; // Kernel kind of 'rule', looked up when it changes
+    // State (2 .. rule.states - 1) of each dying cell, 0 for live and dead
+    // cells, current and next generation (dense storage, Generations rules)
+    std::vector<uint8_t> dying;
+    std::vector<uint8_t> nextDying;
+    // Current, next and previous generations for stability checks (dense storage)
+    GenerationRing<std::vector<std::vector<bool>>> generations;
+    // Current, next and previous generations for stability checks (packed/tiled storage)
+    GenerationRing<BitGrid> packedGenerations;
+    // Rows per block of the binary world format
+    static constexpr int binaryRowsPerBlock = 64;
+    // Start of the checkpoint trailer of a binary world file
+    static constexpr char checkpointMagic[8] = { 'G', 'O', 'L', 'C', 'K', 'P', 'T', '1' };
+    // Rows wider than this many words are evolved in column blocks
+    static constexpr int columnBlockWords = 1024;
+    // Regions of at least this many cells are read and written by all threads
+    static constexpr int64_t regionParallelCells = 1 << 16;
+    std::vector<std::vector<uint64_t>> haloRows; // Per-thread copies of neighbouring band edges
+    // Cache budget (in words) for the two buffers of a temporally blocked tile
+    static constexpr int blockCacheWords = 32768;
+    std::vector<std::vector<uint64_t>> blockScratch; // Per-thread temporal blocking buffers
+    // Current, next and previous generations for stability checks (sparse storage)
+    GenerationRing<SparseGrid> sparseGenerations;
+    std::vector<SparseGrid::ChunkKey> sparseCandidates; // Scratch: chunks evolved this step
+    std::vector<SparseGrid::Chunk> sparseResults;       // Scratch: their next generation
+
+    // Active-region tracking (tiled storage). A tile is 64 rows of one word,
+    // i.e. 64x64 cells; only tiles whose 3x3 neighbourhood changed in the last
+    // generation are recomputed.
+    static constexpr int tileRows = 64;
+    int tilesX;                           // Tiles per row band (= words per row)
+    int tilesY;                           // Number of row bands
+    std::vector<int64_t> tileChangedAt;   // Generation at which each tile last changed
+    std::vector<uint8_t> tileActive;      // Tiles recomputed in the current step
+    std::vector<uint8_t> tileSpread;      // Scratch: tiles next to a changed tile in the same band
+    static constexpr int tileMergeGap = 8;    // Inactive gaps up to this many tiles are recomputed
+    std::vector<StateHash> tileHashes;    // Hash contribution of each tile
+    std::vector<uint64_t> tileDiff;       // Scratch: changed bits of each tile in the current step
+    std::vector<int> tileScratch;         // Scratch: per-band run and copy lists
+    int activeTiles;                      // Number of tiles recomputed in the last step
+    // Per-tile metrics, refreshed at sampled generations for the tiles that
+    // changed since (see refreshTileMetrics)
+    std::vector<int64_t> tileMetricsAt;   // Generation each tile's metrics describe, -1 if never
+    std::vector<uint32_t> tilePopulation; // Live cells of each tile
+    std::vector<uint64_t> tileColumns;    // OR of the rows of each tile
+    std::vector<uint64_t> tileRowMask;    // Bit r set if row r of the tile has live cells
+
+    // Number of generations kept for the stability check
+    static constexpr size_t historyDepth = 3;
+
+    uint64_t generation;        // Number of generations evolved since creation/load
+    StateHash stateHash;        // Hash of the current generation, computed while evolving
+    bool cycleDetection;        // Whether generations are hashed for the stability check
+    int maxCyclePeriod;         // Longest cycle period the stability check looks for
+    int cyclePeriod;            // Period of the detected cycle, 0 if none
+    StateHistory seenStates;    // Recently seen state hashes and their generations
+
+    // Metrics stream: every metricsInterval-th generation (0 = never) is
+    // measured while it is evolved. Each thread sums its band into its own
+    // scratch, merged into 'metrics' once the generation is complete.
+    struct MetricsScratch {
+        GenerationMetrics totals;
+        std::vector<uint64_t> columns; // OR of the band's live words
+        std::vector<uint8_t> rows;     // Per band row: 1 = live cells, 2 = changed
+    };
+    uint64_t metricsInterval;
+    bool metricsDue;                   // The generation being evolved is measured
+    bool metricsValid;                 // 'metrics' describes the current generation
+    bool loaded;                       // False if the file constructor could not load its file
+    GenerationMetrics metrics;
+    std::vector<MetricsScratch> metricsScratch;
+
+    // Helper function to calculate the number of live neighbors for a cell
+    int countNeighbors(const std::vector<std::vector<bool>>& current, int x, int y) {
+        int count = 0;
+        for (int i = -1; i <= 1; i++) {
+            for (int j = -1; j <= 1; j++) {
+                if (i == 0 && j == 0) continue; // Skip the cell itself
+                
+                // Handle toroidal world by wrapping around edges
+                int nx = (x + i + width) % width;
+                int ny = (y + j + height) % height;
+                
+                if (current[ny][nx]) count++;
+            }
+        }
+        return count;
+    }
+
+    // Evolve the packed grid one generation, 64 cells per word operation.
+    // Each thread evolves its own row band (the rows it first touched). The
+    // two rows it needs from neighbouring bands are copied into a thread-local
+    // halo first, and very wide rows are processed in column blocks so the
+    // three input rows of a block stay in cache.
+    void evolvePacked() {
+        uint64_t hashLo = 0, hashHi = 0;
+        prepareBands();
+
+        #pragma omp parallel reduction(+:hashLo,hashHi)
+        {
+            uint64_t start = GOL_PROFILE_START();
+            evolvePackedBand(omp_get_thread_num(), omp_get_num_threads(), hashLo, hashHi);
+            GOL_PROFILE_BAND(omp_get_thread_num(), start);
+        }
+        stateHash.lo = hashLo;
+        stateHash.hi = hashHi;
+    }
+
+    // Size the per-thread buffers used by the band evolve functions
+    void prepareBands() {
+        if (haloRows.size() < static_cast<size_t>(omp_get_max_threads())) {
+            haloRows.resize(omp_get_max_threads());
+        }
+        if (metricsScratch.size() < static_cast<size_t>(omp_get_max_threads())) {
+            metricsScratch.resize(omp_get_max_threads());
+        }
+    }
+
+    // Start a thread's share of a measured generation, or return null if
+    // this generation is not measured
+    MetricsScratch* beginBandMetrics(int thread, int words, int rows) {
+        if (!metricsDue) return nullptr;
+        MetricsScratch& scratch = metricsScratch[thread];
+        scratch.totals = GenerationMetrics();
+        scratch.columns.assign(words, 0);
+        scratch.rows.assign(rows, 0);
+        return &scratch;
+    }
+
+    // Turn a band's per-row flags and column OR into its bounding box and
+    // changed row count
+    static void finishBandMetrics(MetricsScratch& scratch, int begin) {
+        int rows = static_cast<int>(scratch.rows.size());
+        int first = 0, last = rows - 1;
+        while (first < rows && !(scratch.rows[first] & 1)) first++;
+        while (last > first && !(scratch.rows[last] & 1)) last--;
+        if (first < rows) {
+            scratch.totals.extendColumns(scratch.columns.data(), static_cast<int>(scratch.columns.size()), 0,
+                                         begin + first, begin + last);
+        }
+        for (uint8_t flags : scratch.rows) scratch.totals.active += flags >> 1;
+    }
+
+    // Combine the threads' metrics of the generation just evolved (now the
+    // current one) and clear them for the next measured generation
+    void finishMetrics() {
+        metrics = GenerationMetrics();
+        for (MetricsScratch& scratch : metricsScratch) {
+            metrics.merge(scratch.totals);
+            scratch.totals = GenerationMetrics();
+        }
+        metrics.generation = generation;
+        metricsValid = true;
+    }
+
+    // One thread's share of evolvePacked(): its row band of the next
+    // generation, adding the band's row hashes to hashLo/hashHi
+    void evolvePackedBand(int thread, int threads, uint64_t& hashLo, uint64_t& hashHi) {
+        const BitGrid& packedCurrent = packedGenerations.current();
+        BitGrid& packedNext = packedGenerations.next();
+        int nWords = packedCurrent.getWordsPerRow();
+        int lastBits = packedCurrent.lastWordBits();
+        uint64_t lastMask = packedCurrent.lastWordMask();
+        EvolveKernel kernel = KernelRegistry::resolve(ruleKind, rule);
+        bool hashRows = cycleDetection;
+        int begin, end;
+        rowBand(height, thread, threads, begin, end);
+        MetricsScratch* measured = beginBandMetrics(thread, nWords, end - begin);
+        MetricsKernel measure = metricsKernel();
+        uint64_t sums[3 * metricsLanes] = {};
+        if (begin >= end) return;
+
+        // Halo exchange: the edge rows of the bands above and below
+        std::vector<uint64_t>& halo = haloRows[thread];
+        halo.resize(2 * static_cast<size_t>(nWords));
+        const uint64_t* haloSource[2] = { packedCurrent.row((begin + height - 1) % height),
+                                          packedCurrent.row(end % height) };
+        std::copy(haloSource[0], haloSource[0] + nWords, halo.begin());
+        std::copy(haloSource[1], haloSource[1] + nWords, halo.begin() + nWords);
+        const uint64_t* haloAbove = halo.data();
+        const uint64_t* haloBelow = halo.data() + nWords;
+
+        for (int blockBegin = 0; blockBegin < nWords; blockBegin += columnBlockWords) {
+            int blockEnd = std::min(nWords, blockBegin + columnBlockWords);
+            for (int y = begin; y < end; y++) {
+                const uint64_t* above = (y == begin) ? haloAbove : packedCurrent.row(y - 1);
+                const uint64_t* below = (y == end - 1) ? haloBelow : packedCurrent.row(y + 1);
+                evolvePackedRange(above, packedCurrent.row(y), below, packedNext.row(y),
+                                  blockBegin, blockEnd, nWords, lastBits, lastMask, kernel);
+                // Hash the row once its last block is written (still cache-hot)
+                if (hashRows && blockEnd == nWords) {
+                    StateHash h = blockHash(packedNext.row(y), nWords, y);
+                    hashLo += h.lo;
+                    hashHi += h.hi;
+                }
+                if (measured) {
+                    measured->rows[y - begin] |= measure(packedCurrent.row(y), packedNext.row(y), blockBegin, blockEnd,
+                                                         measured->columns.data(), sums);
+                }
+            }
+        }
+        if (measured) {
+            metricsSums(sums, measured->totals);
+            finishBandMetrics(*measured, begin);
+        }
+    }
+
+    // Advance the packed grid 'steps' generations in one memory pass
+    // (temporal blocking). Each thread walks its row band in tiles of full
+    // rows; a tile is loaded with a 'steps'-row halo on either side, evolved
+    // 'steps' times in cache-resident scratch rows (the valid area shrinks by
+    // one row per side each generation) and only the final rows are written
+    // back. The torus is periodic, so halos simply wrap around.
+    void evolvePackedBlocked(int steps) {
+        const BitGrid& packedCurrent = packedGenerations.current();
+        BitGrid& packedNext = packedGenerations.next();
+        int nWords = packedCurrent.getWordsPerRow();
+        int lastBits = packedCurrent.lastWordBits();
+        uint64_t lastMask = packedCurrent.lastWordMask();
+        EvolveKernel kernel = KernelRegistry::resolve(ruleKind, rule);
+        // Tile height: as many rows as fit the cache budget next to the halos
+        int tileHeight = std::max(steps, blockCacheWords / (2 * nWords) - 2 * steps);
+        if (blockScratch.size() < static_cast<size_t>(omp_get_max_threads())) {
+            blockScratch.resize(omp_get_max_threads());
+        }
+
+        #pragma omp parallel
+        {
+            int thread = omp_get_thread_num();
+            int begin, end;
+            rowBand(height, thread, omp_get_num_threads(), begin, end);
+            std::vector<uint64_t>& scratch = blockScratch[thread];
+            size_t bufferWords = static_cast<size_t>(tileHeight + 2 * steps) * nWords;
+            if (begin < end) {
+                scratch.resize(2 * bufferWords);
+            }
+
+            for (int y0 = begin; y0 < end; y0 += tileHeight) {
+                int rows = std::min(tileHeight, end - y0) + 2 * steps;
+                uint64_t* source = scratch.data();
+                uint64_t* target = scratch.data() + bufferWords;
+                for (int r = 0; r < rows; r++) {
+                    int y = static_cast<int>(((static_cast<int64_t>(y0) - steps + r) % height + height) % height);
+                    std::copy(packedCurrent.row(y), packedCurrent.row(y) + nWords, source + static_cast<size_t>(r) * nWords);
+                }
+                for (int g = 1; g <= steps; g++) {
+                    bool last = (g == steps);
+                    for (int r = g; r < rows - g; r++) {
+                        // The final generation goes straight to the next grid
+                        uint64_t* out = last ? packedNext.row(y0 + r - steps) : target + static_cast<size_t>(r) * nWords;
+                        evolvePackedRow(source + static_cast<size_t>(r - 1) * nWords, source + static_cast<size_t>(r) * nWords,
+                                        source + static_cast<size_t>(r + 1) * nWords, out,
+                                        nWords, lastBits, lastMask, kernel);
+                    }
+                    std::swap(source, target);
+                }
+            }
+        }
+
+        // The next generation becomes current; the ring keeps the previous ones
+        packedGenerations.advance();
+    }
+
+    // Hash contribution of one tile of the given grid
+    StateHash tileHash(const BitGrid& grid, int tx, int ty) const {
+        uint64_t words[tileRows];
+        int rows = std::min(tileRows, height - ty * tileRows);
+        for (int r = 0; r < rows; r++) {
+            words[r] = grid.row(ty * tileRows + r)[tx];
+        }
+        return blockHash(words, rows, static_cast<uint64_t>(ty) * tilesX + tx);
+    }
+
+    // Evolve the tiled grid one generation, only recomputing tiles whose
+    // neighbourhood changed in the previous generation. The other tiles keep
+    // their state; they are copied into the next buffer only if it holds an
+    // older, different version of them.
+    void evolveTiled() {
+        const BitGrid& packedCurrent = packedGenerations.current();
+        BitGrid& packedNext = packedGenerations.next();
+        int nWords = packedCurrent.getWordsPerRow();
+        int lastBits = packedCurrent.lastWordBits();
+        uint64_t lastMask = packedCurrent.lastWordMask();
+        EvolveKernel kernel = KernelRegistry::resolve(ruleKind, rule);
+        int64_t now = static_cast<int64_t>(generation);
+        // The next buffer holds the generation historyDepth - 1 steps back,
+        // unless it was exchanged for a checkpoint: then every tile is stale
+        int64_t nextBufferGeneration = packedGenerations.nextIntact()
+                                     ? now + 1 - static_cast<int64_t>(historyDepth) : INT64_MIN;
+        bool hashTiles = cycleDetection;
+
+        // Pass 1: mark tiles with a changed tile in their 3x3 neighbourhood,
+        // first dilating the changed flags horizontally, then vertically
+        #pragma omp parallel for schedule(static)
+        for (int ty = 0; ty < tilesY; ty++) {
+            const int64_t* changedRow = &tileChangedAt[static_cast<size_t>(ty) * tilesX];
+            uint8_t* spreadRow = &tileSpread[static_cast<size_t>(ty) * tilesX];
+            for (int tx = 0; tx < tilesX; tx++) {
+                int west = (tx == 0) ? tilesX - 1 : tx - 1;
+                int east = (tx == tilesX - 1) ? 0 : tx + 1;
+                spreadRow[tx] = changedRow[west] == now || changedRow[tx] == now || changedRow[east] == now;
+            }
+        }
+        int active = 0;
+        #pragma omp parallel for schedule(static) reduction(+:active)
+        for (int ty = 0; ty < tilesY; ty++) {
+            const uint8_t* north = &tileSpread[static_cast<size_t>(ty == 0 ? tilesY - 1 : ty - 1) * tilesX];
+            const uint8_t* middle = &tileSpread[static_cast<size_t>(ty) * tilesX];
+            const uint8_t* south = &tileSpread[static_cast<size_t>(ty == tilesY - 1 ? 0 : ty + 1) * tilesX];
+            uint8_t* activeRow = &tileActive[static_cast<size_t>(ty) * tilesX];
+            for (int tx = 0; tx < tilesX; tx++) {
+                activeRow[tx] = north[tx] | middle[tx] | south[tx];
+                active += activeRow[tx];
+            }
+        }
+        activeTiles = active;
+
+        // Pass 2: evolve runs of active tiles band by band, row by row
+        uint64_t hashLo = 0, hashHi = 0;
+        MetricsKernel measure = metricsKernel();
+        #pragma omp parallel for schedule(dynamic) reduction(+:hashLo,hashHi)
+        for (int ty = 0; ty < tilesY; ty++) {
+            size_t bandBase = static_cast<size_t>(ty) * tilesX;
+            const uint8_t* activeRow = &tileActive[bandBase];
+            int64_t* changedRow = &tileChangedAt[bandBase];
+            uint64_t* diffRow = &tileDiff[bandBase];
+            int yBegin = ty * tileRows;
+            int yEnd = std::min(yBegin + tileRows, height);
+
+            // Plan the band once: runs of tiles to recompute and stale tiles to copy
+            int* runs = &tileScratch[static_cast<size_t>(ty) * 2 * (tilesX + 1)];
+            int* copies = runs + tilesX + 1;
+            int runCount = 0, copyCount = 0;
+            for (int tx = 0; tx < tilesX; ) {
+                if (!activeRow[tx]) {
+                    // Unaffected tile: bring the next buffer up to date if needed
+                    if (changedRow[tx] > nextBufferGeneration) {
+                        copies[copyCount++] = tx;
+                    }
+                    tx++;
+                    continue;
+                }
+                // Extend the run over active tiles and across short inactive
+                // gaps: recomputing an unaffected tile just reproduces it,
+                // and long runs keep the vector kernels busy
+                int runEnd = tx + 1;
+                while (runEnd < tilesX) {
+                    if (activeRow[runEnd]) {
+                        runEnd++;
+                        continue;
+                    }
+                    int gapEnd = runEnd;
+                    while (gapEnd < tilesX && !activeRow[gapEnd] && gapEnd - runEnd < tileMergeGap) gapEnd++;
+                    if (gapEnd == tilesX || !activeRow[gapEnd]) break;
+                    runEnd = gapEnd;
+                }
+                runs[runCount++] = tx;
+                runs[runCount++] = runEnd;
+                tx = runEnd;
+            }
+            if (runCount == 0 && copyCount == 0) continue;
+
+            std::fill(diffRow, diffRow + tilesX, 0);
+            // Births and deaths of a measured generation (population and
+            // bounds come from the per-tile metrics afterwards)
+            MetricsScratch* measured = metricsDue ? &metricsScratch[omp_get_thread_num()] : nullptr;
+            uint64_t sums[3 * metricsLanes] = {};
+            if (measured) measured->columns.resize(tilesX);
+            for (int y = yBegin; y < yEnd; y++) {
+                const uint64_t* above = packedCurrent.row((y + height - 1) % height);
+                const uint64_t* row = packedCurrent.row(y);
+                const uint64_t* below = packedCurrent.row((y + 1) % height);
+                uint64_t* out = packedNext.row(y);
+                for (int r = 0; r < runCount; r += 2) {
+                    evolvePackedRange(above, row, below, out, runs[r], runs[r + 1], nWords, lastBits, lastMask, kernel);
+                    for (int t = runs[r]; t < runs[r + 1]; t++) {
+                        diffRow[t] |= out[t] ^ row[t];
+                    }
+                    if (measured) measure(row, out, runs[r], runs[r + 1], measured->columns.data(), sums);
+                }
+                for (int c = 0; c < copyCount; c++) {
+                    out[copies[c]] = row[copies[c]];
+                }
+            }
+            if (measured) {
+                GenerationMetrics changes;
+                metricsSums(sums, changes);
+                measured->totals.births += changes.births;
+                measured->totals.deaths += changes.deaths;
+            }
+
+            for (int tx = 0; tx < tilesX; tx++) {
+                if (diffRow[tx] == 0) continue;
+                changedRow[tx] = now + 1;
+                if (hashTiles) {
+                    StateHash& stored = tileHashes[bandBase + tx];
+                    StateHash fresh = tileHash(packedNext, tx, ty);
+                    hashLo += fresh.lo - stored.lo;
+                    hashHi += fresh.hi - stored.hi;
+                    stored = fresh;
+                }
+            }
+        }
+        stateHash.lo += hashLo;
+        stateHash.hi += hashHi;
+        if (metricsDue) {
+            refreshTileMetrics();
+        }
+    }
+
+    // Measured generation of a tiled world (the next buffer): recount the
+    // tiles changed since their metrics were last taken, then sum population
+    // and bounds over the per-tile values, which is cheap next to the cells
+    void refreshTileMetrics() {
+        const BitGrid& packedNext = packedGenerations.next();
+        int64_t now = static_cast<int64_t>(generation) + 1;
+        #pragma omp parallel for schedule(dynamic)
+        for (int ty = 0; ty < tilesY; ty++) {
+            GenerationMetrics& totals = metricsScratch[omp_get_thread_num()].totals;
+            int rows = std::min(tileRows, height - ty * tileRows);
+            for (int tx = 0; tx < tilesX; tx++) {
+                size_t t = static_cast<size_t>(ty) * tilesX + tx;
+                if (tileChangedAt[t] >= tileMetricsAt[t] || tileMetricsAt[t] > now) {
+                    uint64_t population = 0, columns = 0, rowMask = 0;
+                    for (int r = 0; r < rows; r++) {
+                        uint64_t word = packedNext.row(ty * tileRows + r)[tx];
+                        population += static_cast<uint64_t>(__builtin_popcountll(word));
+                        columns |= word;
+                        rowMask |= static_cast<uint64_t>(word != 0) << r;
+                    }
+                    tilePopulation[t] = static_cast<uint32_t>(population);
+                    tileColumns[t] = columns;
+                    tileRowMask[t] = rowMask;
+                    tileMetricsAt[t] = now;
+                }
+                if (tilePopulation[t] == 0) continue;
+                totals.population += tilePopulation[t];
+                int64_t x0 = static_cast<int64_t>(tx) * 64, y0 = static_cast<int64_t>(ty) * tileRows;
+                totals.extend(x0 + __builtin_ctzll(tileColumns[t]), y0 + __builtin_ctzll(tileRowMask[t]),
+                              x0 + 63 - __builtin_clzll(tileColumns[t]), y0 + 63 - __builtin_clzll(tileRowMask[t]));
+            }
+        }
+        metricsScratch[0].totals.active += static_cast<uint64_t>(activeTiles);
+    }
+
+    // Forget the recorded state hashes, e.g. after the world was edited
+    void clearCycleHistory() {
+        seenStates.clear();
+        cyclePeriod = 0;
+    }
+
+    // Record the hash of the current generation and check whether the same
+    // state occurred within the last maxCyclePeriod generations. A hash match is
+    // confirmed with a full grid compare when that generation is still stored.
+    void detectCycle() {
+        cyclePeriod = 0;
+        uint64_t seenAt = 0;
+        if (seenStates.find(stateHash, seenAt) && generation - seenAt <= static_cast<uint64_t>(maxCyclePeriod)) {
+            size_t period = static_cast<size_t>(generation - seenAt);
+            bool confirmed = true;
+            if (storage == Storage::Sparse && sparseGenerations.has(period)) {
+                confirmed = sparseGenerations.back(0) == sparseGenerations.back(period);
+            } else if ((storage == Storage::Packed || storage == Storage::Tiled) && packedGenerations.has(period)) {
+                confirmed = packedGenerations.back(0) == packedGenerations.back(period);
+            } else if (storage == Storage::Dense && generations.has(period)) {
+                confirmed = generations.back(0) == generations.back(period);
+            }
+            if (confirmed) {
+                cyclePeriod = static_cast<int>(period);
+            }
+        }
+
+        // States too old to close a cycle of at most maxCyclePeriod are dropped
+        seenStates.record(stateHash, generation, static_cast<uint64_t>(maxCyclePeriod));
+    }
+
+    static uint64_t chunkIndex(const SparseGrid::ChunkKey& key) {
+        return mix64(static_cast<uint64_t>(key.x) * 0xC2B2AE3D27D4EB4FULL + static_cast<uint64_t>(key.y));
+    }
+
+    // Evolve the sparse plane one generation. Every allocated chunk is
+    // evolved, plus each missing neighbour whose facing edge has live cells
+    // (the only places births can happen outside allocated chunks).
+    void evolveSparse() {
+        const SparseGrid& current = sparseGenerations.current();
+        SparseGrid& next = sparseGenerations.next();
+        next.clear();
+
+        sparseCandidates.clear();
+        std::unordered_set<SparseGrid::ChunkKey, SparseGrid::ChunkKeyHasher> border;
+        for (const auto& entry : current.getChunks()) {
+            const SparseGrid::ChunkKey& key = entry.first;
+            const SparseGrid::Chunk& chunk = entry.second;
+            sparseCandidates.push_back(key);
+
+            uint64_t anyWord = 0;
+            for (uint64_t word : chunk) anyWord |= word;
+            uint64_t top = chunk[0], bottom = chunk[SparseGrid::chunkSize - 1];
+            bool edge[3][3] = {
+                { (top & 1) != 0, top != 0, (top >> 63) != 0 },
+                { (anyWord & 1) != 0, false, (anyWord >> 63) != 0 },
+                { (bottom & 1) != 0, bottom != 0, (bottom >> 63) != 0 }
+            };
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    if (!edge[dy + 1][dx + 1]) continue;
+                    SparseGrid::ChunkKey neighbour{ key.x + dx, key.y + dy };
+                    if (!current.find(neighbour)) border.insert(neighbour);
+                }
+            }
+        }
+        sparseCandidates.insert(sparseCandidates.end(), border.begin(), border.end());
+        sparseResults.resize(sparseCandidates.size());
+
+        bool hashChunks = cycleDetection;
+        EvolveKernel kernel = KernelRegistry::resolve(ruleKind, rule);
+        uint64_t hashLo = 0, hashHi = 0;
+        int count = static_cast<int>(sparseCandidates.size());
+        #pragma omp parallel for schedule(dynamic, 16) reduction(+:hashLo,hashHi)
+        for (int i = 0; i < count; i++) {
+            const SparseGrid::ChunkKey& key = sparseCandidates[i];
+            const SparseGrid::Chunk* neighbours[3][3];
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    neighbours[dy + 1][dx + 1] = current.find(SparseGrid::ChunkKey{ key.x + dx, key.y + dy });
+                }
+            }
+            evolveSparseChunk(neighbours, sparseResults[i], kernel);
+            if (metricsDue) {
+                measureChunk(key, neighbours[1][1], sparseResults[i], metricsScratch[omp_get_thread_num()].totals);
+            }
+            if (hashChunks) {
+                StateHash h = blockHash(sparseResults[i].data(), SparseGrid::chunkSize, chunkIndex(key));
+                hashLo += h.lo;
+                hashHi += h.hi;
+            }
+        }
+
+        if (metricsDue) {
+            metricsScratch[0].totals.active += static_cast<uint64_t>(count);
+        }
+
+        // Only non-empty chunks are kept
+        for (int i = 0; i < count; i++) {
+            if (!SparseGrid::isEmpty(sparseResults[i])) {
+                next.insert(sparseCandidates[i], sparseResults[i]);
+            }
+        }
+        stateHash.lo = hashLo;
+        stateHash.hi = hashHi;
+    }
+
+    // Add a chunk's next generation to a measured generation's metrics;
+    // 'before' is its current generation, null if it was not allocated
+    static void measureChunk(const SparseGrid::ChunkKey& key, const SparseGrid::Chunk* before,
+                             const SparseGrid::Chunk& after, GenerationMetrics& totals) {
+        uint64_t columns = 0, rowMask = 0;
+        for (int r = 0; r < SparseGrid::chunkSize; r++) {
+            uint64_t a = before ? (*before)[r] : 0, b = after[r];
+            totals.population += static_cast<uint64_t>(__builtin_popcountll(b));
+            totals.births += static_cast<uint64_t>(__builtin_popcountll(b & ~a));
+            totals.deaths += static_cast<uint64_t>(__builtin_popcountll(a & ~b));
+            columns |= b;
+            rowMask |= static_cast<uint64_t>(b != 0) << r;
+        }
+        if (columns == 0) return;
+        int64_t x0 = key.x * SparseGrid::chunkSize, y0 = key.y * SparseGrid::chunkSize;
+        totals.extend(x0 + __builtin_ctzll(columns), y0 + __builtin_ctzll(rowMask),
+                      x0 + 63 - __builtin_clzll(columns), y0 + 63 - __builtin_clzll(rowMask));
+    }
+
+    // Words of the calling thread's row hashing scratch, reused across rows
+    // and generations (only reallocated for a wider world)
+    static uint64_t* hashScratch(size_t count) {
+        static thread_local std::vector<uint64_t> words;
+        if (words.size() < count) words.resize(count);
+        return words.data();
+    }
+
+    // Hash one row of the dense grid, packing it into words first so that it
+    // hashes exactly like the same row in packed storage
+    StateHash denseRowHash(const std::vector<bool>& row, int y) const {
+        int count = (width + 63) / 64;
+        uint64_t* words = hashScratch(count);
+        std::fill(words, words + count, 0);
+        for (int x = 0; x < width; x++) {
+            if (row[x]) words[x >> 6] |= 1ULL << (x & 63);
+        }
+        return blockHash(words, count, y);
+    }
+
+    // Hash one row of dying states (Generations rules); rows are indexed
+    // after the cell rows so the two never share a block index
+    StateHash dyingRowHash(const std::vector<uint8_t>& states, int y) const {
+        int count = (width + 7) / 8;
+        uint64_t* words = hashScratch(count);
+        words[count - 1] = 0;
+        std::memcpy(words, states.data() + static_cast<size_t>(y) * width, width);
+        return blockHash(words, count, height + y);
+    }
+
+    // Hash the whole current generation (this also refreshes the per-tile hashes)
+    StateHash computeStateHash() {
+        StateHash total;
+        if (storage == Storage::Sparse) {
+            for (const auto& entry : sparseGenerations.current().getChunks()) {
+                total += blockHash(entry.second.data(), SparseGrid::chunkSize, chunkIndex(entry.first));
+            }
+            return total;
+        }
+        if (storage == Storage::Tiled) {
+            for (int ty = 0; ty < tilesY; ty++) {
+                for (int tx = 0; tx < tilesX; tx++) {
+                    StateHash h = tileHash(packedGenerations.current(), tx, ty);
+                    tileHashes[static_cast<size_t>(ty) * tilesX + tx] = h;
+                    total += h;
+                }
+            }
+            return total;
+        }
+        for (int y = 0; y < height; y++) {
+            if (storage == Storage::Packed) {
+                const BitGrid& grid = packedGenerations.current();
+                total += blockHash(grid.row(y), grid.getWordsPerRow(), y);
+            } else {
+                total += denseRowHash(generations.current()[y], y);
+                if (!dying.empty()) total += dyingRowHash(dying, y);
+            }
+        }
+        return total;
+    }
+
+    // Fill out[] with the packed rows [y0, y1) of the current generation
+    // (BitGrid layout, (width + 63) / 64 words per row)
+    void packRows(int y0, int y1, uint64_t* out) const {
+        packGridRows(storage, width, generations.current(), packedGenerations.current(),
+                     sparseGenerations.current(), y0, y1, out);
+    }
+
+    // Read a binary world (see BinaryWorldHeader) from a mapped file. Raw rows
+    // are copied in parallel straight into the packed grid; RLE blocks are
+    // located with one pass over their lengths and then decoded in parallel.
+    bool loadBinary(const MappedFile& mapped, const std::string& filename) {
+        BinaryWorldHeader header;
+        if (mapped.size() < sizeof(header)) {
+            std::cerr << "Error: Truncated world file " << filename << std::endl;
+            return false;
+        }
+        std::memcpy(&header, mapped.data(), sizeof(header));
+        if (header.version != 1 || header.width == 0 || header.height == 0 || header.rowsPerBlock == 0 ||
+            header.width > 0x7FFFFFFFu || header.height > 0x7FFFFFFFu ||
+            header.storage > static_cast<uint32_t>(Storage::Sparse)) {
+            std::cerr << "Error: Unsupported world file " << filename << std::endl;
+            return false;
+        }
+
+        int nWords = static_cast<int>((header.width + 63) / 64);
+        int rowsPerBlock = static_cast<int>(std::min(header.rowsPerBlock, header.height));
+        int blocks = static_cast<int>((header.height + rowsPerBlock - 1) / rowsPerBlock);
+        const uint64_t* data = reinterpret_cast<const uint64_t*>(mapped.data() + sizeof(header));
+        size_t available = (mapped.size() - sizeof(header)) / sizeof(uint64_t);
+
+        std::vector<size_t> offsets;
+        if (!binaryBlockOffsets(header, data, available, offsets)) {
+            std::cerr << "Error: Truncated world file " << filename << std::endl;
+            return false;
+        }
+
+        width = static_cast<int>(header.width);
+        height = static_cast<int>(header.height);
+        storage = static_cast<Storage>(header.storage);
+        resetGenerations();
+
+        // Packed worlds decode in place; the others go through a packed copy
+        bool direct = (storage == Storage::Packed || storage == Storage::Tiled);
+        BitGrid staging = direct ? BitGrid() : BitGrid(width, height);
+        BitGrid& grid = direct ? packedGenerations.current() : staging;
+        bool valid = true;
+        #pragma omp parallel for schedule(static) reduction(&&:valid)
+        for (int b = 0; b < blocks; b++) {
+            int y0 = b * rowsPerBlock;
+            size_t count = static_cast<size_t>(std::min(rowsPerBlock, height - y0)) * nWords;
+            if (header.flags & binaryWorldRLE) {
+                valid = decodeWordsRLE(data + offsets[b] + 1, offsets[b + 1] - offsets[b] - 1, grid.row(y0), count) && valid;
+            } else {
+                std::copy(data + offsets[b], data + offsets[b] + count, grid.row(y0));
+            }
+        }
+        if (!valid) {
+            std::cerr << "Error: Corrupt world file " << filename << std::endl;
+            resetGenerations();
+            return false;
+        }
+
+        // Padding bits past the width must stay zero
+        uint64_t lastMask = grid.lastWordMask();
+        for (int y = 0; y < height; y++) {
+            grid.row(y)[nWords - 1] &= lastMask;
+        }
+
+        if (!direct) unpackRows(grid.row(0));
+        // Saved generation counter; every tile counts as changed at it
+        generation = header.generation;
+        std::fill(tileChangedAt.begin(), tileChangedAt.end(), static_cast<int64_t>(generation));
+
+        // Checkpoints carry the cycle-detection window after the rows
+        const uint8_t* trailer = reinterpret_cast<const uint8_t*>(data + offsets[blocks]);
+        size_t trailerBytes = mapped.size() - sizeof(header) - offsets[blocks] * sizeof(uint64_t);
+        if (trailerBytes >= sizeof(checkpointMagic) + 8 &&
+            std::memcmp(trailer, checkpointMagic, sizeof(checkpointMagic)) == 0) {
+            uint32_t counts[2];
+            std::memcpy(counts, trailer + sizeof(checkpointMagic), sizeof(counts));
+            const uint8_t* entries = trailer + sizeof(checkpointMagic) + sizeof(counts);
+            size_t entryBytes = trailerBytes - sizeof(checkpointMagic) - sizeof(counts);
+            if (counts[0] > 0 && entryBytes >= counts[1] * 24ULL) {
+                // All chunks of a sparse world replace its view
+                const uint8_t* chunks = entries + counts[1] * 24ULL;
+                size_t chunkBytes = entryBytes - counts[1] * 24ULL;
+                const size_t chunkRecord = 2 * sizeof(int64_t) + sizeof(SparseGrid::Chunk);
+                uint64_t chunkCount = 0;
+                if (chunkBytes >= sizeof(chunkCount)) std::memcpy(&chunkCount, chunks, sizeof(chunkCount));
+                if (storage == Storage::Sparse && chunkCount > 0 &&
+                    (chunkBytes - sizeof(chunkCount)) / chunkRecord >= chunkCount) {
+                    SparseGrid& grid = sparseGenerations.current();
+                    grid.clear();
+                    for (uint64_t c = 0; c < chunkCount; c++) {
+                        const uint8_t* record = chunks + sizeof(chunkCount) + c * chunkRecord;
+                        int64_t key[2];
+                        SparseGrid::Chunk chunk;
+                        std::memcpy(key, record, sizeof(key));
+                        std::memcpy(chunk.data(), record + sizeof(key), sizeof(chunk));
+                        grid.insert(SparseGrid::ChunkKey{ key[0], key[1] }, chunk);
+                    }
+                }
+                maxCyclePeriod = static_cast<int>(counts[0]);
+                for (uint32_t e = 0; e < counts[1]; e++) {
+                    uint64_t words[3];
+                    std::memcpy(words, entries + e * 24ULL, sizeof(words));
+                    StateHash hash;
+                    hash.lo = words[0];
+                    hash.hi = words[1];
+                    seenStates.record(hash, words[2], static_cast<uint64_t>(maxCyclePeriod));
+                }
+                if (!seenStates.empty()) stateHash = computeStateHash(); // Also fills the tile hashes
+            }
+        }
+        return true;
+    }
+
+    // Make packed rows (BitGrid layout, padding bits clear) the current
+    // generation; sparse worlds get them as their view and nothing else
+    void unpackRows(const uint64_t* rows) {
+        int nWords = (width + 63) / 64;
+        if (storage == Storage::Dense) {
+            std::vector<std::vector<bool>>& cells = generations.current();
+            std::fill(dying.begin(), dying.end(), 0);
+            #pragma omp parallel for schedule(static)
+            for (int y = 0; y < height; y++) {
+                const uint64_t* row = rows + static_cast<size_t>(y) * nWords;
+                for (int x = 0; x < width; x++) {
+                    cells[y][x] = (row[x >> 6] >> (x & 63)) & 1;
+                }
+            }
+        } else if (storage == Storage::Sparse) {
+            SparseGrid& grid = sparseGenerations.current();
+            grid.clear();
+            for (int y = 0; y < height; y++) {
+                for (int w = 0; w < nWords; w++) {
+                    for (uint64_t bits = rows[static_cast<size_t>(y) * nWords + w]; bits; bits &= bits - 1) {
+                        grid.set(w * 64 + __builtin_ctzll(bits), y, true);
+                    }
+                }
+            }
+        } else {
+            BitGrid& grid = packedGenerations.current();
+            std::copy(rows, rows + static_cast<size_t>(height) * nWords, grid.row(0));
+        }
+    }
+
+    // Allocate (or drop) the dying-state planes for the current rule
+    void resetDying() {
+        size_t cells = (storage == Storage::Dense && rule.isGenerations()) ? static_cast<size_t>(width) * height : 0;
+        dying.assign(cells, 0);
+        nextDying.assign(cells, 0);
+    }
+
+    // Allocate the generation buffers for the current dimensions and storage
+    void resetGenerations() {
+        generation = 0;
+        clearCycleHistory();
+        if (storage == Storage::Sparse) {
+            sparseGenerations.reset(historyDepth, SparseGrid());
+        } else if (storage != Storage::Dense) {
+            packedGenerations.reset(historyDepth, BitGrid(width, height));
+        } else {
+            generations.reset(historyDepth, std::vector<std::vector<bool>>(height, std::vector<bool>(width, false)));
+            placeMemory();
+        }
+        resetDying();
+
+        // Every tile counts as changed at generation 0, so the first step is complete
+        tilesX = (storage == Storage::Tiled) ? (width + 63) / 64 : 0;
+        tilesY = (storage == Storage::Tiled) ? (height + tileRows - 1) / tileRows : 0;
+        tileChangedAt.assign(static_cast<size_t>(tilesX) * tilesY, 0);
+        tileActive.assign(static_cast<size_t>(tilesX) * tilesY, 0);
+        tileSpread.assign(static_cast<size_t>(tilesX) * tilesY, 0);
+        tileHashes.assign(static_cast<size_t>(tilesX) * tilesY, StateHash());
+        tileDiff.assign(static_cast<size_t>(tilesX) * tilesY, 0);
+        tileScratch.assign(static_cast<size_t>(tilesY) * 2 * (tilesX + 1), 0);
+        activeTiles = tilesX * tilesY;
+        tileMetricsAt.assign(static_cast<size_t>(tilesX) * tilesY, -1);
+        tilePopulation.assign(static_cast<size_t>(tilesX) * tilesY, 0);
+        tileColumns.assign(static_cast<size_t>(tilesX) * tilesY, 0);
+        tileRowMask.assign(static_cast<size_t>(tilesX) * tilesY, 0);
+    }
+
+public:
+    // Constructor for new world with given dimensions
+    GameOfLife(int w, int h, Storage s = Storage::Dense)
+        : width(w), height(h), storage(s), generation(0), cycleDetection(true), maxCyclePeriod(64), cyclePeriod(0),
+          metricsInterval(0), metricsDue(false), metricsValid(false), loaded(true) {
+        ruleKind = KernelRegistry::kindOf(rule);
+        // Initialize the current generation and the history buffers
+        resetGenerations();
+    }
+
+    // Constructor for loading from file. The rule is set before loading, so
+    // a restored cycle history stays valid; a Generations rule falls back to
+    // its two-state part if the file is not in dense storage.
+    GameOfLife(const std::string& filename, const LifeRule& r = LifeRule())
+        : width(0), height(0), storage(Storage::Dense), rule(r), generation(0), cycleDetection(true),
+          maxCyclePeriod(64), cyclePeriod(0), metricsInterval(0), metricsDue(false), metricsValid(false),
+          loaded(false) {
+        loaded = load(filename);
+        if (!loaded) {
+            // Leave a valid empty world, whatever the failed load got to
+            width = 0;
+            height = 0;
+            storage = Storage::Dense;
+            resetGenerations();
+        }
+        if (rule.isGenerations() && storage != Storage::Dense) {
+            rule.states = 2;
+            resetDying();
+        }
+        ruleKind = KernelRegistry::kindOf(rule);
+    }
+
+    // Evolve the world one generation - PARALLELIZED VERSION
+    void evolve() {
+        // A fresh (or edited) history starts with the state we evolve from
+        if (cycleDetection && seenStates.empty()) {
+            stateHash = computeStateHash();
+            detectCycle();
+        }
+        beginGeneration();
+
+        {
+            GOL_PROFILE_SCOPE(Evolve);
+            if (storage == Storage::Packed) {
+                evolvePacked();
+            } else if (storage == Storage::Tiled) {
+                evolveTiled();
+            } else if (storage == Storage::Sparse) {
+                evolveSparse();
+            } else {
+                evolveDense();
+            }
+        }
+        GOL_PROFILE_CELLS(updatedCells());
+        advanceGenerations();
+
+        generation++;
+        if (metricsDue) finishMetrics();
+        if (cycleDetection) {
+            GOL_PROFILE_SCOPE(CycleCheck);
+            detectCycle();
+        }
+    }
+
+    // Decide whether the generation about to be evolved is measured
+    void beginGeneration() {
+        metricsDue = metricsInterval > 0 && (generation + 1) % metricsInterval == 0;
+        metricsValid = false;
+        if (metricsDue) prepareBands();
+    }
+
+    // Advance 'steps' generations. Packed worlds without cycle detection use
+    // temporal blocking; otherwise (every generation must be hashed and kept
+    // for the stability check) this steps one generation at a time. Blocks
+    // stop short of a measured generation, which is evolved on its own.
+    void evolveSteps(int steps) {
+        while (steps > 0) {
+            int blocked = steps;
+            if (metricsInterval > 0) {
+                blocked = static_cast<int>(std::min<uint64_t>(blocked, metricsInterval - 1 - generation % metricsInterval));
+            }
+            if (blocked > 1 && supportsTemporalBlocking()) {
+                {
+                    GOL_PROFILE_SCOPE(Evolve);
+                    evolvePackedBlocked(blocked);
+                }
+                for (int i = 0; i < blocked; i++) GOL_PROFILE_CELLS(updatedCells());
+                generation += blocked;
+                metricsValid = false;
+                steps -= blocked;
+            } else {
+                evolve();
+                steps--;
+            }
+        }
+    }
+
+    // Whether evolveSteps() can advance several generations per memory pass
+    bool supportsTemporalBlocking() const {
+        return storage == Storage::Packed && !cycleDetection;
+    }
+
+    // Evolve the dense grid one generation, each thread over its own row band
+    void evolveDense() {
+        uint64_t hashLo = 0, hashHi = 0;
+
+        // Rows have no dependencies between them within a generation
+        #pragma omp parallel reduction(+:hashLo,hashHi)
+        {
+            uint64_t start = GOL_PROFILE_START();
+            evolveDenseBand(omp_get_thread_num(), omp_get_num_threads(), hashLo, hashHi);
+            GOL_PROFILE_BAND(omp_get_thread_num(), start);
+        }
+        if (cycleDetection) {
+            stateHash.lo = hashLo;
+            stateHash.hi = hashHi;
+        }
+    }
+
+    // The next generation becomes current; the ring keeps the previous ones
+    void advanceGenerations() {
+        GOL_PROFILE_SCOPE(Advance);
+        if (storage == Storage::Sparse) {
+            sparseGenerations.advance();
+        } else if (storage == Storage::Dense) {
+            generations.advance();
+            dying.swap(nextDying);
+        } else {
+            packedGenerations.advance();
+        }
+    }
+
+    // Cells computed by the last step (tiled and sparse worlds skip some)
+    uint64_t updatedCells() const {
+        if (storage == Storage::Tiled) {
+            return static_cast<uint64_t>(activeTiles) * tileRows * 64;
+        }
+        if (storage == Storage::Sparse) {
+            return static_cast<uint64_t>(sparseCandidates.size()) * SparseGrid::chunkSize * 64;
+        }
+        return static_cast<uint64_t>(width) * height;
+    }
+
+    // Add row y's live cells, births, deaths and live span to 'totals',
+    // comparing the row before and after the step. Kept out of the evolve
+    // loop so unmeasured generations do not pay for it
+    void measureDenseRow(const std::vector<bool>& before, const std::vector<bool>& after, int y,
+                         GenerationMetrics& totals) const {
+        int live = 0, born = 0, died = 0, first = width, last = -1;
+        for (int x = 0; x < width; x++) {
+            bool wasAlive = before[x], alive = after[x];
+            live += alive;
+            born += alive && !wasAlive;
+            died += wasAlive && !alive;
+            if (alive) {
+                first = std::min(first, x);
+                last = x;
+            }
+        }
+        totals.population += live;
+        totals.births += born;
+        totals.deaths += died;
+        totals.active += (born + died) > 0;
+        if (live > 0) totals.extend(first, y, last, y);
+    }
+
+    // One thread's share of evolveDense(): its row band of the next
+    // generation, adding the band's row hashes to hashLo/hashHi
+    void evolveDenseBand(int thread, int threads, uint64_t& hashLo, uint64_t& hashHi) {
+        const std::vector<std::vector<bool>>& current = generations.current();
+        std::vector<std::vector<bool>>& next = generations.next();
+        int begin, end;
+        rowBand(height, thread, threads, begin, end);
+        bool aging = !dying.empty();
+        const uint16_t birth = rule.birth, survive = rule.survive;
+        MetricsScratch* measured = beginBandMetrics(thread, 0, 0);
+        for (int y = begin; y < end; y++) {
+            for (int x = 0; x < width; x++) {
+                int neighbors = countNeighbors(current, x, y);
+                bool isAlive = current[y][x];
+
+                // Apply the rule: survival for live cells, birth for dead ones
+                uint16_t mask = isAlive ? survive : birth;
+                bool alive = (mask >> neighbors) & 1;
+                if (aging) {
+                    // Live cells that die start dying; dying cells age and
+                    // cannot be born until they are dead
+                    size_t i = static_cast<size_t>(y) * width + x;
+                    uint8_t state = dying[i];
+                    if (state) {
+                        alive = false;
+                        nextDying[i] = (state + 1 < rule.states) ? state + 1 : 0;
+                    } else {
+                        nextDying[i] = (isAlive && !alive) ? 2 : 0;
+                    }
+                }
+                next[y][x] = alive;
+            }
+            if (measured) measureDenseRow(current[y], next[y], y, measured->totals);
+
+            // Hash the new row for cycle detection
+            if (cycleDetection) {
+                StateHash h = denseRowHash(next[y], y);
+                if (aging) h += dyingRowHash(nextDying, y);
+                hashLo += h.lo;
+                hashHi += h.hi;
+            }
+        }
+    }
+
+    // Run up to 'count' generations inside a single parallel region.
+    // The team stays alive across generations: each generation is one band
+    // evolve per thread, a barrier, and a short serial step (ring advance,
+    // cycle detection, afterGeneration) run by one thread. afterGeneration
+    // receives the number of generations done and returns false to stop.
+    // Tiled and sparse storage have serial phases of their own and are
+    // stepped with evolve(). Returns the number of generations run.
+    int runGenerations(int count, const std::function<bool(int)>& afterGeneration) {
+        if (storage != Storage::Packed && storage != Storage::Dense) {
+            for (int done = 1; done <= count; done++) {
+                evolve();
+                if (afterGeneration && !afterGeneration(done)) return done;
+            }
+            return count;
+        }
+
+        // A fresh (or edited) history starts with the state we evolve from
+        if (cycleDetection && seenStates.empty()) {
+            stateHash = computeStateHash();
+            detectCycle();
+        }
+        prepareBands();
+        beginGeneration();
+
+        int done = 0;
+        bool stop = false;
+        uint64_t hashLo = 0, hashHi = 0; // Shared per-generation hash accumulators
+        uint64_t generationStart = GOL_PROFILE_START();
+        #pragma omp parallel
+        {
+            int thread = omp_get_thread_num();
+            int threads = omp_get_num_threads();
+            for (int g = 0; g < count; g++) {
+                uint64_t bandLo = 0, bandHi = 0;
+                uint64_t start = GOL_PROFILE_START();
+                if (storage == Storage::Packed) {
+                    evolvePackedBand(thread, threads, bandLo, bandHi);
+                } else {
+                    evolveDenseBand(thread, threads, bandLo, bandHi);
+                }
+                GOL_PROFILE_BAND(thread, start);
+                if (cycleDetection) {
+                    #pragma omp atomic
+                    hashLo += bandLo;
+                    #pragma omp atomic
+                    hashHi += bandHi;
+                }
+                uint64_t waitStart = GOL_PROFILE_START();
+                #pragma omp barrier
+                GOL_PROFILE_WAIT(thread, waitStart);
+                #pragma omp single
+                {
+                    GOL_PROFILE_PHASE(Evolve, generationStart);
+                    GOL_PROFILE_CELLS(updatedCells());
+                    if (cycleDetection) {
+                        stateHash.lo = hashLo;
+                        stateHash.hi = hashHi;
+                        hashLo = hashHi = 0;
+                    }
+                    advanceGenerations();
+                    generation++;
+                    if (metricsDue) finishMetrics();
+                    if (cycleDetection) {
+                        GOL_PROFILE_SCOPE(CycleCheck);
+                        detectCycle();
+                    }
+                    done++;
+                    stop = afterGeneration && !afterGeneration(done);
+                    if (!stop && done < count) beginGeneration();
+                    generationStart = GOL_PROFILE_START();
+                }
+                // The implicit barrier of 'single' publishes the new state and 'stop'
+                if (stop) break;
+            }
+        }
+        return done;
+    }
+
+    // Check if the world is stable, i.e. the current state repeats one of the
+    // last maxCyclePeriod generations (still lifes, oscillators of any period)
+    bool isStable() const {
+        return cyclePeriod > 0;
+    }
+
+    // Period of the cycle the world has entered, 0 if no cycle was detected
+    int getCyclePeriod() const {
+        return cyclePeriod;
+    }
+
+    // Set the longest cycle period the stability check looks for
+    void setMaxCyclePeriod(int period) {
+        maxCyclePeriod = period;
+        clearCycleHistory();
+    }
+
+    int getMaxCyclePeriod() const {
+        return maxCyclePeriod;
+    }
+
+    // Enable/disable hashing generations for the stability check
+    void setCycleDetection(bool enabled) {
+        cycleDetection = enabled;
+        clearCycleHistory();
+    }
+
+    // Measure every n-th generation (by generation number) while evolving
+    // it; 0 stops measuring
+    void setMetricsInterval(uint64_t n) {
+        metricsInterval = n;
+        metricsValid = false;
+    }
+
+    // Whether getMetrics() describes the current generation, i.e. it was
+    // measured and nothing evolved since
+    bool hasMetrics() const {
+        return metricsValid && metrics.generation == generation;
+    }
+
+    const GenerationMetrics& getMetrics() const {
+        return metrics;
+    }
+
+    // Number of generations evolved since the world was created or loaded
+    uint64_t getGeneration() const {
+        return generation;
+    }
+
+    // Print the current state of the world - PARALLELIZED VERSION
+    void print() {
+        // Pre-compute all output strings in parallel
+        std::vector<std::string> lines(height);
+        
+        #pragma omp parallel for schedule(static)
+        for (int y = 0; y < height; y++) {
+            std::string line;
+            line.reserve(width * 4 + 1); // Reserve space for efficiency
+            for (int x = 0; x < width; x++) {
+                line += (getCell(x, y) ? "■ " : "□ ");
+            }
+            line += '\n';
+            lines[y] = line;
+        }
+        
+        // Sequential output to maintain order, flushed once
+        for (int y = 0; y < height; y++) {
+            std::cout << lines[y];
+        }
+        std::cout.flush();
+    }
+
+    // Load world from file. Binary files are recognized by their magic
+    // bytes; anything else is read as the text format.
+    bool load(const std::string& filename) {
+        MappedFile mapped;
+        if (!mapped.open(filename)) {
+            std::cerr << "Error: Could not open file " << filename << std::endl;
+            return false;
+        }
+        if (mapped.size() >= sizeof(binaryWorldMagic) &&
+            std::memcmp(mapped.data(), binaryWorldMagic, sizeof(binaryWorldMagic)) == 0) {
+            return loadBinary(mapped, filename);
+        }
+
+        std::ifstream file(filename);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not open file " << filename << std::endl;
+            return false;
+        }
+        
+        file >> width >> height;
+        
+        // Resize and initialize grids, this also resets the history
+        resetGenerations();
+        
+        // Read cell states
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                int state;
+                file >> state;
+                setCell(x, y, state == 1);
+            }
+        }
+        
+        file.close();
+        return true;
+    }
+
+    // Save world to file (text format)
+    bool save(const std::string& filename) {
+        std::ofstream file(filename);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not open file " << filename << std::endl;
+            return false;
+        }
+        
+        // Write dimensions
+        file << width << " " << height << std::endl;
+        
+        // Write cell states, one buffered line per row
+        std::string line;
+        for (int y = 0; y < height; y++) {
+            line.clear();
+            for (int x = 0; x < width; x++) {
+                line += getCell(x, y) ? "1 " : "0 ";
+            }
+            line += '\n';
+            file << line;
+        }
+        
+        file.close();
+        return file.good();
+    }
+
+    // Save world to file in the binary format, streamed one block of rows at
+    // a time (optionally RLE-compressed). Sparse worlds save their view.
+    bool saveBinary(const std::string& filename, bool compress) {
+        return writeBinaryWorld(filename, compress, storage, width, height, generation,
+                                [this](int y0, int y1, uint64_t* out) { packRows(y0, y1, out); }, nullptr);
+    }
+
+    // Size a snapshot's buffers for this world so it can be exchanged with a
+    // ring slot (a one-time allocation when checkpointing starts)
+    void prepareSnapshot(Snapshot& snapshot) const {
+        if (snapshot.storage == storage && snapshot.width == width && snapshot.height == height) return;
+        snapshot.storage = storage;
+        snapshot.width = width;
+        snapshot.height = height;
+        snapshot.dense.clear();
+        snapshot.packed = BitGrid();
+        snapshot.sparse.clear();
+        if (storage == Storage::Dense) {
+            snapshot.dense.assign(height, std::vector<bool>(width, false));
+        } else if (storage != Storage::Sparse) {
+            snapshot.packed = BitGrid(width, height);
+        }
+    }
+
+    // Take the previous generation (the state before the last step, 'steps'
+    // generations ago) out of the world by swapping its ring slot with the
+    // snapshot's buffer - no copy. Returns false if that generation is no
+    // longer stored. The snapshot must have been prepared for this world.
+    bool exchangeCheckpoint(Snapshot& snapshot, uint64_t steps) {
+        bool available = (storage == Storage::Sparse) ? sparseGenerations.has(1)
+                       : (storage == Storage::Dense) ? generations.has(1) : packedGenerations.has(1);
+        if (!available || steps > generation) return false;
+        if (storage == Storage::Sparse) {
+            sparseGenerations.exchange(1, snapshot.sparse);
+        } else if (storage == Storage::Dense) {
+            generations.exchange(1, snapshot.dense);
+        } else {
+            packedGenerations.exchange(1, snapshot.packed);
+        }
+        snapshot.generation = generation - steps;
+        snapshot.maxCyclePeriod = maxCyclePeriod;
+        snapshot.history.clear();
+        seenStates.forEach([&snapshot](const StateHistory::Entry& entry) {
+            if (entry.second <= snapshot.generation) snapshot.history.push_back(entry);
+        });
+        return true;
+    }
+
+    // Copy the current generation into a snapshot (used outside the run
+    // loop, where a copy does not stall evolution)
+    void copyCheckpoint(Snapshot& snapshot) const {
+        if (storage == Storage::Sparse) {
+            snapshot.sparse = sparseGenerations.current();
+        } else if (storage == Storage::Dense) {
+            snapshot.dense = generations.current();
+        } else {
+            snapshot.packed = packedGenerations.current();
+        }
+        snapshot.generation = generation;
+        snapshot.maxCyclePeriod = maxCyclePeriod;
+        snapshot.history.clear();
+        seenStates.forEach([&snapshot](const StateHistory::Entry& entry) { snapshot.history.push_back(entry); });
+    }
+
+    // Fill out[] with every row of the current generation, bit-packed
+    // ((width + 63) / 64 words per row; sparse worlds pack their view)
+    void packGeneration(uint64_t* out) const {
+        packRows(0, height, out);
+    }
+
+    // Replace the current generation with packed rows as produced by
+    // packGeneration() and set the generation counter, e.g. for replay
+    void restoreGeneration(const uint64_t* rows, uint64_t gen) {
+        clearCycleHistory();
+        unpackRows(rows);
+        generation = gen;
+        // Every tile counts as changed, so the next step is complete
+        std::fill(tileChangedAt.begin(), tileChangedAt.end(), static_cast<int64_t>(generation));
+        std::fill(tileMetricsAt.begin(), tileMetricsAt.end(), -1);
+    }
+
+    // Number of recorded states in the cycle-detection window
+    size_t getCycleHistorySize() const {
+        return seenStates.size();
+    }
+
+    // Get cell state from 2D coordinates. Sparse worlds accept any 64-bit
+    // coordinates; bounded worlds report cells outside the grid as dead.
+    bool getCell(int64_t x, int64_t y) const {
+        if (storage == Storage::Sparse) {
+            return sparseGenerations.current().get(x, y);
+        }
+        if (x < 0 || x >= width || y < 0 || y >= height) {
+            return false;
+        }
+        if (storage != Storage::Dense) {
+            return packedGenerations.current().get(static_cast<int>(x), static_cast<int>(y));
+        }
+        return generations.current()[y][x];
+    }
+
+    // Get cell state from 1D index
+    bool getCell(int position) const {
+        int x = position % width;
+        int y = position / width;
+        return getCell(x, y);
+    }
+
+    // Set cell state using 2D coordinates (any 64-bit coordinates for sparse worlds)
+    void setCell(int64_t x, int64_t y, bool state) {
+        if (storage != Storage::Sparse && (x < 0 || x >= width || y < 0 || y >= height)) {
+            return;
+        }
+        if (!seenStates.empty()) {
+            clearCycleHistory(); // Edits break the recorded state sequence
+        }
+        if (storage == Storage::Sparse) {
+            sparseGenerations.current().set(x, y, state);
+            return;
+        }
+        if (storage == Storage::Tiled) {
+            // Edited tiles must be recomputed (with their neighbours) next step
+            tileChangedAt[static_cast<size_t>(y / tileRows) * tilesX + (x >> 6)] = static_cast<int64_t>(generation);
+        }
+        if (storage != Storage::Dense) {
+            packedGenerations.current().set(static_cast<int>(x), static_cast<int>(y), state);
+            return;
+        }
+        generations.current()[y][x] = state;
+        if (!dying.empty()) dying[static_cast<size_t>(y) * width + x] = 0;
+    }
+
+    // Set cell state using 1D index
+    void setCell(int position, bool state) {
+        int x = position % width;
+        int y = position / width;
+        setCell(x, y, state);
+    }
+
+    // Set a cell of a pattern placed relative to (x, y): bounded worlds wrap
+    // around their edges, sparse worlds just extend
+    void placeCell(int64_t x, int64_t y) {
+        if (storage == Storage::Sparse) {
+            setCell(x, y, true);
+            return;
+        }
+        setCell(((x % width) + width) % width, ((y % height) + height) % height, true);
+    }
+
+    // Check whether the rectangle [x, x+w) x [y, y+h) (clipped to the world)
+    // contains no live cells
+    bool isRegionEmpty(int x, int y, int w, int h) const {
+        int x0 = std::max(x, 0), y0 = std::max(y, 0);
+        int x1 = std::min(x + w, width), y1 = std::min(y + h, height);
+        for (int cy = y0; cy < y1; cy++) {
+            if (storage == Storage::Sparse) {
+                for (int cx = x0; cx < x1; cx++) {
+                    if (getCell(cx, cy)) return false;
+                }
+                continue;
+            }
+            if (storage == Storage::Dense) {
+                const std::vector<bool>& row = generations.current()[cy];
+                for (int cx = x0; cx < x1; cx++) {
+                    if (row[cx]) return false;
+                }
+                continue;
+            }
+            const uint64_t* row = packedGenerations.current().row(cy);
+            for (int w0 = x0 >> 6; w0 <= (x1 - 1) >> 6 && x0 < x1; w0++) {
+                uint64_t mask = ~0ULL;
+                if (w0 == (x0 >> 6)) mask &= ~0ULL << (x0 & 63);
+                if (w0 == ((x1 - 1) >> 6) && (x1 & 63) != 0) mask &= (1ULL << (x1 & 63)) - 1;
+                if (row[w0] & mask) return false;
+            }
+        }
+        return true;
+    }
+
+    // Bounded worlds are tori of width x height; sparse worlds are unbounded
+    bool isBounded() const {
+        return storage != Storage::Sparse;
+    }
+
+    // Read 'count' 64-cell words of row y starting at word firstWord (cells
+    // firstWord * 64 onwards) into out[]. Cells outside a bounded world read
+    // as dead.
+    void getRowWords(int64_t y, int64_t firstWord, int count, uint64_t* out) const {
+        gridRowWords(storage, width, height, generations.current(), packedGenerations.current(),
+                     sparseGenerations.current(), y, firstWord, count, out);
+    }
+
+    // Bulk read of the w x h region at (x, y) of the current generation into
+    // packed rows of (w + 63) / 64 words (see readRegion). Cells outside a
+    // bounded world read as dead.
+    void getRegion(int64_t x, int64_t y, int w, int h, uint64_t* out) const {
+        readRegion([this](int64_t row, int64_t firstWord, int count, uint64_t* words) {
+            getRowWords(row, firstWord, count, words);
+        }, x, y, w, h, out);
+    }
+
+    // Bulk write of the w x h region at (x, y) from packed rows laid out as
+    // getRegion() returns them. Each row is shifted into word alignment once
+    // and merged into the grid under a mask; bounded worlds clip the region.
+    void setRegion(int64_t x, int64_t y, int w, int h, const uint64_t* bits) {
+        if (w <= 0 || h <= 0) return;
+        if (!seenStates.empty()) {
+            clearCycleHistory(); // Edits break the recorded state sequence
+        }
+        int inWords = (w + 63) / 64;
+        int shift = static_cast<int>(x & 63);
+        int64_t firstWord = x >> 6;
+        int count = static_cast<int>(((x & 63) + w + 63) / 64); // World words a region row touches
+        uint64_t lastMask = (w % 64 == 0) ? ~0ULL : ((1ULL << (w % 64)) - 1);
+        // Word k of a region row (or of its mask), shifted to world word firstWord + k
+        auto aligned = [&](const uint64_t* row, int k, bool mask) {
+            auto word = [&](int i) -> uint64_t {
+                if (i < 0 || i >= inWords) return 0;
+                uint64_t valid = (i == inWords - 1) ? lastMask : ~0ULL;
+                return mask ? valid : (row[i] & valid);
+            };
+            return shift ? (word(k) << shift) | (word(k - 1) >> (64 - shift)) : word(k);
+        };
+
+        if (storage == Storage::Sparse) {
+            SparseGrid& grid = sparseGenerations.current();
+            for (int r = 0; r < h; r++) {
+                const uint64_t* row = bits + static_cast<size_t>(r) * inWords;
+                for (int k = 0; k < count; k++) {
+                    grid.setWord(firstWord + k, y + r, aligned(row, k, true), aligned(row, k, false));
+                }
+            }
+            return;
+        }
+
+        int r0 = static_cast<int>(std::max<int64_t>(0, -y));
+        int r1 = static_cast<int>(std::min<int64_t>(h, height - y));
+        int nWords = (width + 63) / 64;
+        int64_t k0 = std::max<int64_t>(0, -firstWord);
+        int64_t k1 = std::min<int64_t>(count, nWords - firstWord);
+        if (r0 >= r1 || k0 >= k1) return;
+        uint64_t gridLastMask = (width % 64 == 0) ? ~0ULL : ((1ULL << (width % 64)) - 1);
+        #pragma omp parallel for schedule(static) if (static_cast<int64_t>(w) * h >= regionParallelCells)
+        for (int r = r0; r < r1; r++) {
+            const uint64_t* row = bits + static_cast<size_t>(r) * inWords;
+            int gy = static_cast<int>(y + r);
+            for (int64_t k = k0; k < k1; k++) {
+                int wi = static_cast<int>(firstWord + k);
+                uint64_t mask = aligned(row, static_cast<int>(k), true);
+                uint64_t word = aligned(row, static_cast<int>(k), false);
+                if (wi == nWords - 1) mask &= gridLastMask;
+                if (storage != Storage::Dense) {
+                    uint64_t& target = packedGenerations.current().row(gy)[wi];
+                    target = (target & ~mask) | (word & mask);
+                    continue;
+                }
+                std::vector<bool>& cells = generations.current()[gy];
+                for (uint64_t m = mask; m; m &= m - 1) {
+                    int cx = wi * 64 + __builtin_ctzll(m);
+                    cells[cx] = (word >> (cx & 63)) & 1;
+                    if (!dying.empty()) dying[static_cast<size_t>(gy) * width + cx] = 0;
+                }
+            }
+        }
+        if (storage == Storage::Tiled) {
+            // Edited tiles must be recomputed (with their neighbours) next step
+            for (int ty = (static_cast<int>(y) + r0) / tileRows; ty <= (static_cast<int>(y) + r1 - 1) / tileRows; ty++) {
+                for (int64_t k = k0; k < k1; k++) {
+                    tileChangedAt[static_cast<size_t>(ty) * tilesX + (firstWord + k)] = static_cast<int64_t>(generation);
+                }
+            }
+        }
+    }
+
+    // Smallest rectangle [minX, maxX] x [minY, maxY] holding every live cell,
+    // returns false if the world is empty
+    bool getLiveBounds(int64_t& minX, int64_t& minY, int64_t& maxX, int64_t& maxY) const {
+        bool found = false;
+        auto include = [&](int64_t y, int64_t wordX, uint64_t bits) {
+            int64_t lo = wordX * 64 + __builtin_ctzll(bits);
+            int64_t hi = wordX * 64 + 63 - __builtin_clzll(bits);
+            if (!found) {
+                minX = lo; maxX = hi; minY = y; maxY = y;
+                found = true;
+                return;
+            }
+            minX = std::min(minX, lo); maxX = std::max(maxX, hi);
+            minY = std::min(minY, y); maxY = std::max(maxY, y);
+        };
+        if (storage == Storage::Sparse) {
+            for (const auto& entry : sparseGenerations.current().getChunks()) {
+                for (int r = 0; r < SparseGrid::chunkSize; r++) {
+                    if (entry.second[r]) include(entry.first.y * SparseGrid::chunkSize + r, entry.first.x, entry.second[r]);
+                }
+            }
+            return found;
+        }
+        int nWords = (width + 63) / 64;
+        std::vector<uint64_t> row(nWords);
+        for (int y = 0; y < height; y++) {
+            getRowWords(y, 0, nWords, row.data());
+            for (int w = 0; w < nWords; w++) {
+                if (row[w]) include(y, w, row[w]);
+            }
+        }
+        return found;
+    }
+
+    // Kill every cell of the current generation
+    void clearCells() {
+        if (!seenStates.empty()) {
+            clearCycleHistory();
+        }
+        if (storage == Storage::Sparse) {
+            sparseGenerations.current().clear();
+            return;
+        }
+        if (storage == Storage::Dense) {
+            for (std::vector<bool>& row : generations.current()) {
+                std::fill(row.begin(), row.end(), false);
+            }
+            std::fill(dying.begin(), dying.end(), 0);
+            return;
+        }
+        packedGenerations.current().clear();
+        // All tiles may have changed
+        std::fill(tileChangedAt.begin(), tileChangedAt.end(), static_cast<int64_t>(generation));
+    }
+
+    // Advance the generation counter for a state computed outside evolve()
+    // (e.g. by the HashLife engine). The recorded cycle history no longer
+    // matches the state sequence and is dropped.
+    void skipGenerations(uint64_t count) {
+        generation += count;
+        clearCycleHistory();
+        std::fill(tileChangedAt.begin(), tileChangedAt.end(), static_cast<int64_t>(generation));
+    }
+
+    // Add a glider pattern
+    void addGlider(int64_t x, int64_t y) {
+        // Glider pattern:
+        // □■□
+        // □□■
+        // ■■■
+        placeCell(x + 1, y);
+        placeCell(x + 2, y + 1);
+        placeCell(x, y + 2);
+        placeCell(x + 1, y + 2);
+        placeCell(x + 2, y + 2);
+    }
+
+    // Add a toad pattern (period-2 oscillator)
+    void addToad(int64_t x, int64_t y) {
+        // Toad pattern:
+        // □□□□
+        // □■■■
+        // ■■■□
+        // □□□□
+        placeCell(x + 1, y + 1);
+        placeCell(x + 2, y + 1);
+        placeCell(x + 3, y + 1);
+        placeCell(x, y + 2);
+        placeCell(x + 1, y + 2);
+        placeCell(x + 2, y + 2);
+    }
+
+    // Add a beacon pattern (period-2 oscillator)
+    void addBeacon(int64_t x, int64_t y) {
+        // Beacon pattern:
+        // ■■□□
+        // ■■□□
+        // □□■■
+        // □□■■
+        placeCell(x, y);
+        placeCell(x + 1, y);
+        placeCell(x, y + 1);
+        placeCell(x + 1, y + 1);
+        placeCell(x + 2, y + 2);
+        placeCell(x + 3, y + 2);
+        placeCell(x + 2, y + 3);
+        placeCell(x + 3, y + 3);
+    }
+
+    // Add a methuselah pattern (R-pentomino)
+    void addMethuselah(int64_t x, int64_t y) {
+        // R-pentomino pattern (a long-lived methuselah):
+        // □■■
+        // ■■□
+        // □■□
+        placeCell(x + 1, y);
+        placeCell(x + 2, y);
+        placeCell(x, y + 1);
+        placeCell(x + 1, y + 1);
+        placeCell(x + 1, y + 2);
+    }
+
+    // Cells of the preset patterns, as (dx, dy) offsets from the pattern's
+    // corner: the shapes of addGlider(), addToad(), addBeacon() and addMethuselah()
+    struct PresetCells {
+        int count;
+        int8_t dx[8];
+        int8_t dy[8];
+    };
+
+    static const PresetCells& presetCells(int type) {
+        static const PresetCells presets[4] = {
+            { 5, { 1, 2, 0, 1, 2 }, { 0, 1, 2, 2, 2 } },
+            { 6, { 1, 2, 3, 0, 1, 2 }, { 1, 1, 1, 2, 2, 2 } },
+            { 8, { 0, 1, 0, 1, 2, 3, 2, 3 }, { 0, 0, 1, 1, 2, 2, 3, 3 } },
+            { 5, { 1, 2, 0, 1, 1 }, { 0, 0, 1, 1, 2 } }
+        };
+        return presets[type & 3];
+    }
+
+    // Add count random preset patterns, reproducibly: pattern i is drawn from
+    // Philox counter (i, stream 0) under the seed, so the same seed gives the
+    // same world on any number of threads. Patterns are sorted into an even
+    // number of horizontal strips of at least 4 rows; a pattern (at most 4x4)
+    // only reaches into the next strip, so all even strips are stamped in
+    // parallel, then all odd ones, without locks. The result is the union of
+    // the patterns and does not depend on the stamping order.
+    void addRandomPatterns(int64_t count, uint64_t seed) {
+        struct Placement {
+            int x, y, type;
+        };
+        std::vector<Placement> placements(static_cast<size_t>(std::max<int64_t>(count, 0)));
+        #pragma omp parallel for schedule(static)
+        for (int64_t i = 0; i < count; i++) {
+            std::array<uint32_t, 4> r = philox4x32(static_cast<uint32_t>(i), static_cast<uint32_t>(i >> 32), 0, 0, seed);
+            Placement& p = placements[i];
+            p.x = static_cast<int>((static_cast<uint64_t>(r[0]) * width) >> 32);
+            p.y = static_cast<int>((static_cast<uint64_t>(r[1]) * height) >> 32);
+            p.type = static_cast<int>(r[2] & 3);
+        }
+        if (!seenStates.empty()) {
+            clearCycleHistory(); // Edits break the recorded state sequence
+        }
+
+        // Sparse worlds (a shared chunk map) and tiny worlds place serially
+        int strips = std::min(height / 4, 8 * omp_get_max_threads()) & ~1;
+        if (storage == Storage::Sparse || strips < 2) {
+            for (const Placement& p : placements) {
+                const PresetCells& cells = presetCells(p.type);
+                for (int c = 0; c < cells.count; c++) {
+                    placeCell(static_cast<int64_t>(p.x) + cells.dx[c], static_cast<int64_t>(p.y) + cells.dy[c]);
+                }
+            }
+            return;
+        }
+
+        // Counting sort by strip: strip s holds rows [s * height / strips, (s + 1) * height / strips)
+        std::vector<int64_t> stripStart(static_cast<size_t>(strips) + 1, 0);
+        std::vector<int> stripOf(placements.size());
+        for (size_t i = 0; i < placements.size(); i++) {
+            stripOf[i] = static_cast<int>(static_cast<int64_t>(placements[i].y) * strips / height);
+            stripStart[stripOf[i] + 1]++;
+        }
+        for (int s = 0; s < strips; s++) {
+            stripStart[s + 1] += stripStart[s];
+        }
+        std::vector<Placement> sorted(placements.size());
+        {
+            std::vector<int64_t> next(stripStart.begin(), stripStart.end() - 1);
+            for (size_t i = 0; i < placements.size(); i++) {
+                sorted[next[stripOf[i]]++] = placements[i];
+            }
+        }
+
+        BitGrid* grid = (storage == Storage::Dense) ? nullptr : &packedGenerations.current();
+        std::vector<std::vector<bool>>* cells = (storage == Storage::Dense) ? &generations.current() : nullptr;
+        for (int phase = 0; phase < 2; phase++) {
+            #pragma omp parallel for schedule(dynamic, 1)
+            for (int s = phase; s < strips; s += 2) {
+                for (int64_t i = stripStart[s]; i < stripStart[s + 1]; i++) {
+                    const Placement& p = sorted[i];
+                    const PresetCells& preset = presetCells(p.type);
+                    for (int c = 0; c < preset.count; c++) {
+                        int x = p.x + preset.dx[c];
+                        int y = p.y + preset.dy[c];
+                        if (x >= width) x %= width;   // Bounded worlds wrap
+                        if (y >= height) y %= height;
+                        if (grid) {
+                            grid->row(y)[x >> 6] |= 1ULL << (x & 63);
+                        } else {
+                            (*cells)[y][x] = true;
+                            if (!dying.empty()) dying[static_cast<size_t>(y) * width + x] = 0;
+                        }
+                    }
+                }
+            }
+        }
+        // Every tile may have changed
+        std::fill(tileChangedAt.begin(), tileChangedAt.end(), static_cast<int64_t>(generation));
+    }
+
+    // Fill count words (rows of wordsPerRow words, stored back to back) with
+    // random bits, each set with probability level / 256; words[i] is word
+    // first + i of the world, so a strip can be filled on its own. Words are
+    // drawn in pairs from Philox counter (pair, stream 1, draw) under the
+    // seed, so the result does not depend on the thread count. Bit b of the
+    // level (LSB first) ORs or ANDs in a fresh random word; the level's
+    // trailing zero bits would only AND into zero and are skipped, so density
+    // 1/2 costs one draw per pair of words. Callers already inside a parallel
+    // loop pass parallel = false.
+    static void randomWords(uint64_t* words, int64_t first, int64_t count, int wordsPerRow, uint64_t lastMask,
+                            int level, uint64_t seed, bool parallel = true) {
+        int firstBit = (level > 0 && level < 256) ? __builtin_ctz(static_cast<unsigned>(level)) : 8;
+        uint64_t initial = (level >= 256) ? ~0ULL : 0;
+        int64_t end = first + count;
+        #pragma omp parallel for schedule(static) if(parallel)
+        for (int64_t p = first / 2; p < (end + 1) / 2; p++) {
+            uint64_t pair[2] = { initial, initial };
+            for (int b = firstBit; b < 8; b++) {
+                std::array<uint32_t, 4> r = philox4x32(static_cast<uint32_t>(p), static_cast<uint32_t>(p >> 32), 1,
+                                                       static_cast<uint32_t>(b), seed);
+                uint64_t r0 = static_cast<uint64_t>(r[1]) << 32 | r[0];
+                uint64_t r1 = static_cast<uint64_t>(r[3]) << 32 | r[2];
+                if ((level >> b) & 1) {
+                    pair[0] |= r0;
+                    pair[1] |= r1;
+                } else {
+                    pair[0] &= r0;
+                    pair[1] &= r1;
+                }
+            }
+            for (int h = 0; h < 2; h++) {
+                int64_t i = 2 * p + h;
+                if (i < first || i >= end) continue;
+                // Padding bits past the width stay clear
+                words[i - first] = (i % wordsPerRow == wordsPerRow - 1) ? (pair[h] & lastMask) : pair[h];
+            }
+        }
+    }
+
+    // Fill level (alive probability in 1/256 steps) nearest to a density
+    static int densityLevel(double density) {
+        return static_cast<int>(std::lround(std::min(std::max(density, 0.0), 1.0) * 256));
+    }
+
+    // Replace the current generation with a reproducible uniform random fill
+    // of the given density (rounded to 1/256); sparse worlds fill their view.
+    // Packed worlds are filled in place at memory bandwidth.
+    void fillRandom(double density, uint64_t seed) {
+        int level = densityLevel(density);
+        int nWords = (width + 63) / 64;
+        uint64_t lastMask = (width % 64 == 0) ? ~0ULL : ((1ULL << (width % 64)) - 1);
+        int64_t count = static_cast<int64_t>(nWords) * height;
+        clearCycleHistory();
+        if (storage == Storage::Dense || storage == Storage::Sparse) {
+            std::vector<uint64_t> rows(static_cast<size_t>(count));
+            randomWords(rows.data(), 0, count, nWords, lastMask, level, seed);
+            unpackRows(rows.data());
+        } else {
+            randomWords(packedGenerations.current().row(0), 0, count, nWords, lastMask, level, seed);
+        }
+        // Every tile may have changed
+        std::fill(tileChangedAt.begin(), tileChangedAt.end(), static_cast<int64_t>(generation));
+    }
+
+    // Get world width
+    int getWidth() const {
+        return width;
+    }
+
+    // Get world height
+    int getHeight() const {
+        return height;
+    }
+
+    // Get the storage backend of the world
+    // Whether the world was loaded (always true for worlds not made from a file)
+    bool isLoaded() const {
+        return loaded;
+    }
+
+    Storage getStorage() const {
+        return storage;
+    }
+
+    // Get the rule the world evolves by
+    const LifeRule& getRule() const {
+        return rule;
+    }
+
+    // Change the rule. Generations rules need dense storage (the packed
+    // kernels have one bit per cell); returns false for those elsewhere.
+    bool setRule(const LifeRule& newRule) {
+        if (newRule.isGenerations() && storage != Storage::Dense) return false;
+        if (newRule == rule) return true;
+        rule = newRule;
+        ruleKind = KernelRegistry::kindOf(rule);
+        resetDying();
+        clearCycleHistory();
+        // Stable tiles may change under the new rule
+        std::fill(tileChangedAt.begin(), tileChangedAt.end(), static_cast<int64_t>(generation));
+        return true;
+    }
+
+    // Re-place every generation buffer using the row bands of the current
+    // thread count (first touch), e.g. after the number of threads changed
+    void placeMemory() {
+        if (storage == Storage::Dense) {
+            int rows = height;
+            generations.forEachSlot([rows](std::vector<std::vector<bool>>& grid) {
+                #pragma omp parallel
+                {
+                    int begin, end;
+                    rowBand(rows, omp_get_thread_num(), omp_get_num_threads(), begin, end);
+                    for (int y = begin; y < end; y++) {
+                        std::vector<bool> row(grid[y]); // Allocated by the owning thread
+                        grid[y].swap(row);
+                    }
+                }
+            });
+        } else if (storage != Storage::Sparse) {
+            packedGenerations.forEachSlot([](BitGrid& grid) { grid = BitGrid(grid); });
+        }
+        haloRows.clear(); // Reallocated by their new owners on the next step
+    }
+
+    // Number of live cells in the current generation (the whole plane for
+    // sparse worlds)
+    uint64_t getPopulation() const {
+        uint64_t population = 0;
+        if (storage == Storage::Sparse) {
+            for (const auto& entry : sparseGenerations.current().getChunks()) {
+                for (uint64_t word : entry.second) population += __builtin_popcountll(word);
+            }
+        } else if (storage == Storage::Dense) {
+            const std::vector<std::vector<bool>>& cells = generations.current();
+            #pragma omp parallel for schedule(static) reduction(+:population)
+            for (int y = 0; y < height; y++) {
+                population += static_cast<uint64_t>(std::count(cells[y].begin(), cells[y].end(), true));
+            }
+        } else {
+            const BitGrid& grid = packedGenerations.current();
+            size_t words = static_cast<size_t>(grid.getWordsPerRow()) * height;
+            const uint64_t* rows = grid.row(0);
+            #pragma omp parallel for schedule(static) reduction(+:population)
+            for (size_t i = 0; i < words; i++) {
+                population += __builtin_popcountll(rows[i]);
+            }
+        }
+        return population;
+    }
+
+    // Number of allocated 64x64 chunks (sparse storage)
+    size_t getChunkCount() const {
+        return sparseGenerations.current().chunkCount();
+    }
+
+    // Number of tiles recomputed in the last generation (tiled storage)
+    int getActiveTiles() const {
+        return activeTiles;
+    }
+
+    // Total number of tiles (tiled storage)
+    int getTileCount() const {
+        return tilesX * tilesY;
+    }
+
+    // Benchmark function to test performance, advancing 'block' generations
+    // per memory pass where temporal blocking is available
+    double benchmarkEvolution(int generations, int block = 1) {
+        auto start = std::chrono::high_resolution_clock::now();
+        
+        if (block > 1 && supportsTemporalBlocking()) {
+            for (int i = 0; i < generations; i += block) {
+                evolveSteps(std::min(block, generations - i));
+            }
+        } else {
+            runGenerations(generations, nullptr);
+        }
+        
+        auto end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::milli> elapsed = end - start;
+        return elapsed.count();
+    }
+};
+
+// PatternFile class - streaming import/export of community pattern formats
+// RLE (run-length encoded rows, "x = .., y = .." header) and Golly's
+// macrocell format (.mc: a hash-consed quadtree with 8x8 leaves, one node
+// per line, children before parents). Files are read and written in pieces,
+// never as a dense grid. Imported cells land at an offset in the world;
+// bounded worlds clip whatever falls outside them.
+class PatternFile {
+public:
+    // What an import or export processed, for throughput reporting
+    struct Stats {
+        uint64_t bytes = 0;  // File size processed
+        uint64_t cells = 0;  // Live cells placed or written
+        int64_t width = 0;   // Pattern extent
+        int64_t height = 0;
+    };
+
+private:
+    // Macrocell node: a leaf (level 3, 8x8 cells, bit y * 8 + x) or four
+    // child indices (0 = empty, otherwise 1-based node line numbers)
+    struct MacroNode {
+        uint64_t leaf;
+        uint32_t child[4]; // nw, ne, sw, se
+        int level;
+    };
+
+    static constexpr size_t readChunk = 1 << 20;
+
+    // Word index of the 64-cell word holding column x (rounds towards -infinity)
+    static int64_t floorDiv64(int64_t x) {
+        return x >> 6;
+    }
+
+    // Place a macrocell subtree with its top-left corner at (x, y)
+    static void placeMacroNode(GameOfLife& world, const std::vector<MacroNode>& nodes, uint32_t index,
+                               int64_t x, int64_t y, Stats& stats) {
+        if (index == 0) return;
+        const MacroNode& node = nodes[index - 1];
+        int64_t size = int64_t(1) << node.level;
+        if (world.isBounded() && (x >= world.getWidth() || y >= world.getHeight() || x + size <= 0 || y + size <= 0)) {
+            return; // Entirely outside the world
+        }
+        if (node.level == 3) {
+            for (uint64_t bits = node.leaf; bits; bits &= bits - 1) {
+                int bit = __builtin_ctzll(bits);
+                world.setCell(x + (bit & 7), y + (bit >> 3), true);
+                stats.cells++;
+            }
+            return;
+        }
+        int64_t half = size / 2;
+        placeMacroNode(world, nodes, node.child[0], x, y, stats);
+        placeMacroNode(world, nodes, node.child[1], x + half, y, stats);
+        placeMacroNode(world, nodes, node.child[2], x, y + half, stats);
+        placeMacroNode(world, nodes, node.child[3], x + half, y + half, stats);
+    }
+
+    // Extract "x = <n>" style values from an RLE header line
+    static int64_t headerValue(const std::string& line, const std::string& key) {
+        size_t pos = 0;
+        while ((pos = line.find(key, pos)) != std::string::npos) {
+            size_t eq = line.find_first_not_of(" \t", pos + key.size());
+            if ((pos == 0 || line[pos - 1] == ' ' || line[pos - 1] == ',') && eq != std::string::npos && line[eq] == '=') {
+                return std::strtoll(line.c_str() + eq + 1, nullptr, 10);
+            }
+            pos += key.size();
+        }
+        return 0;
+    }
+
+    static std::string headerRule(const std::string& line) {
+        size_t pos = line.find("rule");
+        if (pos == std::string::npos) return "";
+        size_t eq = line.find('=', pos);
+        if (eq == std::string::npos) return "";
+        size_t begin = line.find_first_not_of(" \t", eq + 1);
+        if (begin == std::string::npos) return "";
+        size_t end = line.find_first_of(" \t,\r", begin);
+        return line.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+    }
+
+    // Warn if a pattern's rule (empty means B3/S23) is not the world's rule
+    static void checkRule(const std::string& rule, const GameOfLife& world) {
+        LifeRule parsed;
+        if (!rule.empty() && !LifeRule::parse(rule, parsed)) {
+            std::cout << "Warning: unknown pattern rule " << rule << ", loading the cells anyway" << std::endl;
+        } else if (parsed != world.getRule()) {
+            std::cout << "Warning: pattern rule " << parsed.toString() << " is not the world's rule "
+                      << world.getRule().toString() << " (see 'rule'), loading the cells anyway" << std::endl;
+        }
+    }
+
+public:
+    // Whether a file starts like a macrocell file
+    static bool isMacrocell(const std::string& filename) {
+        std::ifstream file(filename, std::ios::binary);
+        char head[2] = { 0, 0 };
+        file.read(head, 2);
+        return head[0] == '[' && head[1] == 'M';
+    }
+
+    // Import an RLE pattern with its top-left corner at (x, y). The body is
+    // parsed as a stream of <count><tag> tokens in fixed-size chunks.
+    static bool importRLE(GameOfLife& world, const std::string& filename, int64_t x, int64_t y, Stats& stats) {
+        std::ifstream file(filename, std::ios::binary);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not open file " << filename << std::endl;
+            return false;
+        }
+        std::vector<char> buffer(readChunk);
+        std::string line;       // Comment or header line being collected
+        bool inLine = false;    // Collecting a '#' or header line
+        bool lineStart = true;
+        bool inBody = false;
+        bool done = false;
+        int64_t count = 0;      // Pending run count (0 = 1)
+        int64_t cx = 0, cy = 0; // Position within the pattern
+
+        while (!done && file) {
+            file.read(buffer.data(), buffer.size());
+            std::streamsize got = file.gcount();
+            stats.bytes += static_cast<uint64_t>(got);
+            for (std::streamsize i = 0; i < got && !done; i++) {
+                char c = buffer[i];
+                if (inLine) {
+                    if (c == '\n') {
+                        inLine = false;
+                        lineStart = true;
+                        if (!line.empty() && line[0] == 'x') {
+                            stats.width = headerValue(line, "x");
+                            stats.height = headerValue(line, "y");
+                            checkRule(headerRule(line), world);
+                        }
+                    } else {
+                        line += c;
+                    }
+                    continue;
+                }
+                if (lineStart && !inBody && (c == '#' || c == 'x')) {
+                    line.assign(1, c);
+                    inLine = true;
+                    continue;
+                }
+                lineStart = (c == '\n');
+                if (c >= '0' && c <= '9') {
+                    count = count * 10 + (c - '0');
+                    inBody = true;
+                    continue;
+                }
+                if (c == ' ' || c == '\t' || c == '\r' || c == '\n') continue;
+                int64_t run = count > 0 ? count : 1;
+                count = 0;
+                inBody = true;
+                if (c == '!') {
+                    done = true;
+                } else if (c == '$') {
+                    cy += run;
+                    cx = 0;
+                } else if (c == 'b' || c == '.') {
+                    cx += run;
+                } else if (std::isalpha(static_cast<unsigned char>(c))) {
+                    // 'o' (or any other state letter) is a live cell
+                    for (int64_t k = 0; k < run; k++) {
+                        world.setCell(x + cx + k, y + cy, true);
+                    }
+                    cx += run;
+                    stats.cells += static_cast<uint64_t>(run);
+                } else {
+                    std::cerr << "Error: Unexpected character '" << c << "' in " << filename << std::endl;
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Import a macrocell pattern with the top-left corner of its root square
+    // at (x, y). Only the node table is held in memory; it is expanded into
+    // the world subtree by subtree, skipping empty and off-world subtrees.
+    static bool importMacrocell(GameOfLife& world, const std::string& filename, int64_t x, int64_t y, Stats& stats) {
+        std::ifstream file(filename, std::ios::binary);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not open file " << filename << std::endl;
+            return false;
+        }
+        std::vector<MacroNode> nodes;
+        std::string line;
+        while (std::getline(file, line)) {
+            stats.bytes += line.size() + 1;
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty()) continue;
+            if (line[0] == '[') continue;
+            if (line[0] == '#') {
+                if (line.compare(0, 2, "#R") == 0) {
+                    std::string rule = line.substr(2);
+                    rule.erase(0, rule.find_first_not_of(" \t"));
+                    checkRule(rule, world);
+                }
+                continue;
+            }
+            MacroNode node = {};
+            if (line[0] == '.' || line[0] == '*' || line[0] == '$') {
+                // 8x8 leaf: rows of '.'/'*' each ending in '$'
+                node.level = 3;
+                int cx = 0, cy = 0;
+                for (char c : line) {
+                    if (c == '$') {
+                        cy++;
+                        cx = 0;
+                    } else if (cx < 8 && cy < 8) {
+                        if (c == '*') node.leaf |= 1ULL << (cy * 8 + cx);
+                        cx++;
+                    }
+                }
+            } else {
+                // "<level> <nw> <ne> <sw> <se>"
+                const char* cursor = line.c_str();
+                char* endField = nullptr;
+                node.level = static_cast<int>(std::strtol(cursor, &endField, 10));
+                bool parsed = endField != cursor;
+                for (int q = 0; q < 4 && parsed; q++) {
+                    cursor = endField;
+                    node.child[q] = static_cast<uint32_t>(std::strtoul(cursor, &endField, 10));
+                    parsed = endField != cursor;
+                }
+                if (!parsed || node.level < 4 || node.level > 62) {
+                    std::cerr << "Error: Unsupported macrocell node '" << line << "' in " << filename
+                              << " (only two-state patterns are supported)" << std::endl;
+                    return false;
+                }
+                for (uint32_t child : node.child) {
+                    if (child > nodes.size() || (child != 0 && nodes[child - 1].level != node.level - 1)) {
+                        std::cerr << "Error: Invalid node reference in " << filename << std::endl;
+                        return false;
+                    }
+                }
+            }
+            nodes.push_back(node);
+        }
+        if (nodes.empty()) {
+            std::cerr << "Error: No nodes in " << filename << std::endl;
+            return false;
+        }
+        stats.width = stats.height = int64_t(1) << nodes.back().level;
+        placeMacroNode(world, nodes, static_cast<uint32_t>(nodes.size()), x, y, stats);
+        return true;
+    }
+
+    // Export the live area of the world as RLE, streaming row by row
+    static bool exportRLE(const GameOfLife& world, const std::string& filename, Stats& stats) {
+        std::ofstream file(filename, std::ios::binary);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not open file " << filename << std::endl;
+            return false;
+        }
+        int64_t minX = 0, minY = 0, maxX = -1, maxY = -1;
+        world.getLiveBounds(minX, minY, maxX, maxY);
+        stats.width = maxX - minX + 1;
+        stats.height = maxY - minY + 1;
+        file << "#C Generation " << world.getGeneration() << ", top-left cell at (" << minX << ", " << minY << ")\n";
+        file << "x = " << stats.width << ", y = " << stats.height << ", rule = " << world.getRule().toString() << "\n";
+
+        std::string out; // Current output line, wrapped at 70 characters
+        auto emit = [&](int64_t run, char tag) {
+            std::string token = (run > 1 ? std::to_string(run) : std::string()) + tag;
+            if (out.size() + token.size() > 70) {
+                file << out << '\n';
+                out.clear();
+            }
+            out += token;
+        };
+
+        int64_t firstWord = floorDiv64(minX);
+        std::vector<uint64_t> row(static_cast<size_t>(std::max<int64_t>(floorDiv64(maxX) - firstWord + 1, 0)));
+        auto cellAt = [&](int64_t x) {
+            return ((row[static_cast<size_t>(floorDiv64(x) - firstWord)] >> (x & 63)) & 1) != 0;
+        };
+        int64_t pendingRows = 0; // Row ends not written yet
+        for (int64_t y = minY; y <= maxY; y++) {
+            world.getRowWords(y, firstWord, static_cast<int>(row.size()), row.data());
+            for (uint64_t word : row) stats.cells += static_cast<uint64_t>(__builtin_popcountll(word));
+            int64_t x = minX;
+            while (x <= maxX) {
+                bool alive = cellAt(x);
+                int64_t end = x + 1;
+                while (end <= maxX && cellAt(end) == alive) end++;
+                if (!alive && end > maxX) break; // Trailing dead cells are implicit
+                if (pendingRows > 0) {
+                    emit(pendingRows, '$');
+                    pendingRows = 0;
+                }
+                emit(end - x, alive ? 'o' : 'b');
+                x = end;
+            }
+            pendingRows++;
+        }
+        out += '!';
+        file << out << '\n';
+        stats.bytes = static_cast<uint64_t>(file.tellp());
+        file.close();
+        return file.good();
+    }
+
+    // Export the live area of the world as a macrocell file. The quadtree is
+    // built bottom-up one strip of 8 rows at a time: each strip becomes a row
+    // of leaves, and pairs of rows at one level combine into a row at the
+    // next, so only one pending row per level is held. Identical subtrees
+    // share one node line and empty subtrees are written as 0.
+    static bool exportMacrocell(const GameOfLife& world, const std::string& filename, Stats& stats) {
+        std::ofstream file(filename, std::ios::binary);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not open file " << filename << std::endl;
+            return false;
+        }
+        file << "[M2] (conwaysgameoflifecpp)\n#R " << world.getRule().toString() << "\n";
+        int64_t minX = 0, minY = 0, maxX = -1, maxY = -1;
+        if (!world.getLiveBounds(minX, minY, maxX, maxY)) {
+            file << "$\n"; // A single empty leaf
+            stats.bytes = static_cast<uint64_t>(file.tellp());
+            return file.good();
+        }
+
+        // Root square: top-left at a 64-aligned column so leaves are bytes of words
+        int64_t firstWord = floorDiv64(minX);
+        int64_t originX = firstWord * 64;
+        int level = 3;
+        while ((int64_t(1) << level) < std::max(maxX - originX + 1, maxY - minY + 1)) level++;
+        int64_t size = int64_t(1) << level;
+        stats.width = stats.height = size;
+        file << "#C Generation " << world.getGeneration() << ", top-left cell at (" << originX << ", " << minY << ")\n";
+
+        uint32_t nextIndex = 1;
+        std::unordered_map<uint64_t, uint32_t> leaves;
+        struct QuadHasher {
+            size_t operator()(const std::array<uint32_t, 4>& q) const {
+                return static_cast<size_t>(mix64((uint64_t(q[0]) << 32 | q[1]) ^ mix64(uint64_t(q[2]) << 32 | q[3])));
+            }
+        };
+        std::unordered_map<std::array<uint32_t, 4>, uint32_t, QuadHasher> interior;
+        std::string line;
+
+        auto internLeaf = [&](uint64_t bits) -> uint32_t {
+            if (bits == 0) return 0;
+            auto it = leaves.find(bits);
+            if (it != leaves.end()) return it->second;
+            line.clear();
+            int lastRow = 7;
+            while (((bits >> (lastRow * 8)) & 0xFF) == 0) lastRow--;
+            for (int r = 0; r <= lastRow; r++) {
+                unsigned rowBits = (bits >> (r * 8)) & 0xFF;
+                for (int c = 0; rowBits >> c; c++) line += ((rowBits >> c) & 1) ? '*' : '.';
+                line += '$';
+            }
+            file << line << '\n';
+            return leaves[bits] = nextIndex++;
+        };
+        auto internNode = [&](int nodeLevel, const std::array<uint32_t, 4>& quads) -> uint32_t {
+            if ((quads[0] | quads[1] | quads[2] | quads[3]) == 0) return 0;
+            auto it = interior.find(quads);
+            if (it != interior.end()) return it->second;
+            file << nodeLevel << ' ' << quads[0] << ' ' << quads[1] << ' ' << quads[2] << ' ' << quads[3] << '\n';
+            return interior[quads] = nextIndex++;
+        };
+
+        int64_t leavesPerRow = size / 8;
+        int stripWords = static_cast<int>(std::max<int64_t>(size / 64, 1));
+        std::vector<uint64_t> strip(static_cast<size_t>(stripWords) * 8);
+        std::vector<std::vector<uint32_t>> pending(level + 1);
+        std::vector<bool> hasPending(level + 1, false);
+        for (int64_t sy = 0; sy < size / 8; sy++) {
+            for (int r = 0; r < 8; r++) {
+                world.getRowWords(minY + sy * 8 + r, firstWord, stripWords, strip.data() + static_cast<size_t>(r) * stripWords);
+            }
+            std::vector<uint32_t> current(static_cast<size_t>(leavesPerRow));
+            for (int64_t bx = 0; bx < leavesPerRow; bx++) {
+                uint64_t bits = 0;
+                for (int r = 0; r < 8; r++) {
+                    uint64_t word = strip[static_cast<size_t>(r) * stripWords + static_cast<size_t>(bx >> 3)];
+                    bits |= ((word >> ((bx & 7) * 8)) & 0xFF) << (r * 8);
+                }
+                stats.cells += static_cast<uint64_t>(__builtin_popcountll(bits));
+                current[static_cast<size_t>(bx)] = internLeaf(bits);
+            }
+            // Combine with the pending row above, level by level
+            for (int l = 3; ; l++) {
+                if (l == level) break; // The root was the last node written
+                if (!hasPending[l]) {
+                    pending[l].swap(current);
+                    hasPending[l] = true;
+                    break;
+                }
+                const std::vector<uint32_t>& north = pending[l];
+                std::vector<uint32_t> parent(current.size() / 2);
+                for (size_t i = 0; i < parent.size(); i++) {
+                    parent[i] = internNode(l + 1, { north[2 * i], north[2 * i + 1], current[2 * i], current[2 * i + 1] });
+                }
+                hasPending[l] = false;
+                current.swap(parent);
+            }
+        }
+        stats.bytes = static_cast<uint64_t>(file.tellp());
+        file.close();
+        return file.good();
+    }
+};
+
+// HashLife class - quadtree engine for exponential fast-forward
+
+// Cells are stored in a quadtree whose nodes are canonicalized in a hash table
+// (identical subtrees are shared), and each node memoizes its RESULT: the
+// centre half of the node advanced 2^step generations. Repetitive patterns
+// then advance huge numbers of generations with a handful of table lookups.
+class HashLife {
+public:
+    struct Node {
+        Node* nw;            // Quadrants (null for leaves)
+        Node* ne;
+        Node* sw;
+        Node* se;
+        Node* result;        // Memoized centre after 2^step generations
+        Node* chain;         // Next node in the same hash bucket (or free list)
+        uint64_t population; // Number of live cells, saturating at UINT64_MAX
+        int level;           // Node covers 2^level x 2^level cells, -1 if free
+        bool marked;         // Reachability mark used by garbage collection
+    };
+
+private:
+    std::deque<Node> pool;          // Node storage, addresses stay stable
+    Node* freeList;                 // Nodes released by garbage collection
+    std::vector<Node*> buckets;     // Hash table of canonical interior nodes
+    size_t nodeCount;               // Interior nodes in the table
+    Node deadLeaf;                  // Canonical level-0 nodes
+    Node aliveLeaf;
+    std::vector<Node*> emptyNodes;  // Canonical empty node of each level
+    int step;                       // Results advance 2^step generations
+    LifeRule rule;                  // Rule the memoized results were computed with
+    size_t memoryLimit;             // Node memory that triggers garbage collection (bytes)
+    uint64_t collections;           // Number of garbage collections run
+
+    static size_t hashQuads(const Node* nw, const Node* ne, const Node* sw, const Node* se) {
+        uint64_t h = reinterpret_cast<uintptr_t>(nw);
+        h = h * 0x9E3779B97F4A7C15ULL + reinterpret_cast<uintptr_t>(ne);
+        h = h * 0x9E3779B97F4A7C15ULL + reinterpret_cast<uintptr_t>(sw);
+        h = h * 0x9E3779B97F4A7C15ULL + reinterpret_cast<uintptr_t>(se);
+        return static_cast<size_t>(h ^ (h >> 29));
+    }
+
+    void insert(Node* node) {
+        size_t b = hashQuads(node->nw, node->ne, node->sw, node->se) & (buckets.size() - 1);
+        node->chain = buckets[b];
+        buckets[b] = node;
+    }
+
+    void growTable() {
+        std::vector<Node*> old;
+        old.swap(buckets);
+        buckets.assign(old.size() * 2, nullptr);
+        for (Node* head : old) {
+            while (head) {
+                Node* nextNode = head->chain;
+                insert(head);
+                head = nextNode;
+            }
+        }
+    }
+
+    Node* allocate() {
+        if (freeList) {
+            Node* node = freeList;
+            freeList = node->chain;
+            return node;
+        }
+        pool.emplace_back();
+        return &pool.back();
+    }
+
+    // Canonical node with the given quadrants
+    Node* join(Node* nw, Node* ne, Node* sw, Node* se) {
+        size_t b = hashQuads(nw, ne, sw, se) & (buckets.size() - 1);
+        for (Node* n = buckets[b]; n; n = n->chain) {
+            if (n->nw == nw && n->ne == ne && n->sw == sw && n->se == se) return n;
+        }
+        Node* node = allocate();
+        node->nw = nw;
+        node->ne = ne;
+        node->sw = sw;
+        node->se = se;
+        node->result = nullptr;
+        // Saturate: a torus tiled up to a high level has more cells than a
+        // uint64_t counts, and a wrapped sum of 0 would read as empty
+        auto add = [](uint64_t a, uint64_t b) { return (b > UINT64_MAX - a) ? UINT64_MAX : a + b; };
+        node->population = add(add(nw->population, ne->population), add(sw->population, se->population));
+        node->level = nw->level + 1;
+        node->marked = false;
+        node->chain = buckets[b];
+        buckets[b] = node;
+        if (++nodeCount > buckets.size()) growTable();
+        return node;
+    }
+
+    Node* leaf(bool alive) {
+        return alive ? &aliveLeaf : &deadLeaf;
+    }
+
+    // Centre of a node, one level down, without advancing time
+    Node* centre(Node* n) {
+        return join(n->nw->se, n->ne->sw, n->sw->ne, n->se->nw);
+    }
+
+    Node* centreHorizontal(Node* w, Node* e) {
+        return join(w->ne, e->nw, w->se, e->sw);
+    }
+
+    Node* centreVertical(Node* n, Node* s) {
+        return join(n->sw, n->se, s->nw, s->ne);
+    }
+
+    // One generation of the centre 2x2 of a 4x4 (level 2) node
+    Node* baseResult(Node* n) {
+        int cells = 0; // bit (y * 4 + x)
+        Node* quads[4] = { n->nw, n->ne, n->sw, n->se };
+        for (int q = 0; q < 4; q++) {
+            int ox = (q & 1) * 2, oy = (q >> 1) * 2;
+            Node* sub[4] = { quads[q]->nw, quads[q]->ne, quads[q]->sw, quads[q]->se };
+            for (int i = 0; i < 4; i++) {
+                if (sub[i]->population) cells |= 1 << ((oy + (i >> 1)) * 4 + ox + (i & 1));
+            }
+        }
+        bool next[4];
+        for (int i = 0; i < 4; i++) {
+            int x = 1 + (i & 1), y = 1 + (i >> 1);
+            int count = 0;
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    if (dx == 0 && dy == 0) continue;
+                    count += (cells >> ((y + dy) * 4 + x + dx)) & 1;
+                }
+            }
+            bool alive = (cells >> (y * 4 + x)) & 1;
+            next[i] = (((alive ? rule.survive : rule.birth) >> count) & 1) != 0;
+        }
+        return join(leaf(next[0]), leaf(next[1]), leaf(next[2]), leaf(next[3]));
+    }
+
+    // RESULT of a node of level >= 2: its centre advanced 2^step generations
+    // (the step must satisfy step <= level - 2)
+    Node* result(Node* n) {
+        if (n->result) return n->result;
+        if (n->population == 0) return n->result = emptyNode(n->level - 1);
+        if (n->level == 2) return n->result = baseResult(n);
+
+        // Nine overlapping subnodes one level down
+        Node* n00 = n->nw;
+        Node* n01 = centreHorizontal(n->nw, n->ne);
+        Node* n02 = n->ne;
+        Node* n10 = centreVertical(n->nw, n->sw);
+        Node* n11 = centre(n);
+        Node* n12 = centreVertical(n->ne, n->se);
+        Node* n20 = n->sw;
+        Node* n21 = centreHorizontal(n->sw, n->se);
+        Node* n22 = n->se;
+
+        Node* r[9];
+        Node* subs[9] = { n00, n01, n02, n10, n11, n12, n20, n21, n22 };
+        bool fullStep = (step >= n->level - 2);
+        for (int i = 0; i < 9; i++) {
+            // A full step spends half the time here and half below; a smaller
+            // step only crops here and spends all of it below
+            r[i] = fullStep ? result(subs[i]) : centre(subs[i]);
+        }
+        Node* res = join(result(join(r[0], r[1], r[3], r[4])),
+                         result(join(r[1], r[2], r[4], r[5])),
+                         result(join(r[3], r[4], r[6], r[7])),
+                         result(join(r[4], r[5], r[7], r[8])));
+        n->result = res;
+        return res;
+    }
+
+    // Change the step size; memoized results are only valid for one step
+    void setStep(int newStep) {
+        if (newStep == step) return;
+        step = newStep;
+        for (Node& n : pool) {
+            n.result = nullptr;
+        }
+    }
+
+    // Change the rule; memoized results are only valid for one rule
+    void setRule(const LifeRule& newRule) {
+        if (newRule == rule) return;
+        rule = newRule;
+        for (Node& n : pool) {
+            n.result = nullptr;
+        }
+    }
+
+    void mark(Node* n) {
+        while (n && !n->marked && n->level > 0) {
+            n->marked = true;
+            mark(n->nw);
+            mark(n->ne);
+            mark(n->sw);
+            n = n->se;
+        }
+    }
+
+    // Build the quadtree for the square [x, x + 2^level) x [y, y + 2^level)
+    Node* build(const GameOfLife& world, int x, int y, int level) {
+        if (level == 0) return leaf(world.getCell(x, y));
+        int size = 1 << level;
+        if (level >= 4 && world.isRegionEmpty(x, y, size, size)) return emptyNode(level);
+        int half = size / 2;
+        return join(build(world, x, y, level - 1), build(world, x + half, y, level - 1),
+                    build(world, x, y + half, level - 1), build(world, x + half, y + half, level - 1));
+    }
+
+    // Write the live cells of a node into the world at (x, y)
+    void write(GameOfLife& world, Node* n, int x, int y) {
+        if (n->population == 0) return;
+        if (n->level == 0) {
+            world.setCell(x, y, true);
+            return;
+        }
+        int half = 1 << (n->level - 1);
+        write(world, n->nw, x, y);
+        write(world, n->ne, x + half, y);
+        write(world, n->sw, x, y + half);
+        write(world, n->se, x + half, y + half);
+    }
+
+public:
+    HashLife()
+        : freeList(nullptr), nodeCount(0), step(-1),
+          memoryLimit(static_cast<size_t>(1024) * 1024 * 1024), collections(0) {
+        buckets.assign(1 << 16, nullptr);
+        deadLeaf = Node{ nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, 0, 0, false };
+        aliveLeaf = Node{ nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, 1, 0, false };
+    }
+
+    HashLife(const HashLife&) = delete;
+    HashLife& operator=(const HashLife&) = delete;
+
+    // Canonical empty node of the given level
+    Node* emptyNode(int level) {
+        while (static_cast<int>(emptyNodes.size()) <= level) {
+            if (emptyNodes.empty()) {
+                emptyNodes.push_back(&deadLeaf);
+            } else {
+                Node* e = emptyNodes.back();
+                emptyNodes.push_back(join(e, e, e, e));
+            }
+        }
+        return emptyNodes[level];
+    }
+
+    // HashLife runs on toroidal worlds that are square with a power-of-two side
+    static int worldLevel(const GameOfLife& world) {
+        if (world.getStorage() == GameOfLife::Storage::Sparse) return -1;
+        int size = world.getWidth();
+        if (size != world.getHeight() || size < 2 || (size & (size - 1)) != 0) return -1;
+        int level = 0;
+        while ((1 << level) < size) level++;
+        return level;
+    }
+
+    // Advance a 2^k x 2^k torus given as a level-k node by 'generations'.
+    // The torus is the infinite plane tiled with copies of it; a node made of
+    // such copies evolves exactly like the torus. Each set bit j of the count
+    // is one RESULT of a tiled node of level max(k + 1, j + 2) at step 2^j.
+    Node* advanceTorus(Node* world, uint64_t generations) {
+        int k = world->level;
+        for (int j = 0; j < 64; j++) {
+            if (!((generations >> j) & 1)) continue;
+            int level = std::max(k + 1, j + 2);
+            Node* tiled = world;
+            while (tiled->level < level) {
+                tiled = join(tiled, tiled, tiled, tiled);
+            }
+            setStep(j);
+            Node* r = result(tiled);
+            if (level - 2 >= k) {
+                // The result starts at a multiple of the torus size: any
+                // aligned level-k block is the evolved torus
+                while (r->level > k) r = r->nw;
+            } else {
+                // The result is the torus shifted by half its size; the centre
+                // of four copies shifts it back
+                r = centre(join(r, r, r, r));
+            }
+            world = r;
+            if (memoryUsage() > memoryLimit) {
+                collectGarbage(world);
+            }
+        }
+        return world;
+    }
+
+    // Advance a square power-of-two toroidal world by 'generations'.
+    // Generations rules have more than two cell states and are not supported.
+    bool jump(GameOfLife& world, uint64_t generations) {
+        int level = worldLevel(world);
+        if (level < 0 || world.getRule().isGenerations()) return false;
+        setRule(world.getRule());
+        Node* root = build(world, 0, 0, level);
+        root = advanceTorus(root, generations);
+        world.clearCells();
+        write(world, root, 0, 0);
+        world.skipGenerations(generations);
+        if (memoryUsage() > memoryLimit) {
+            collectGarbage(nullptr);
+        }
+        return true;
+    }
+
+    // Free every node not reachable from root; memoized results are kept
+    // only where they point at surviving nodes
+    void collectGarbage(Node* root) {
+        for (Node& n : pool) n.marked = false;
+        mark(root);
+        for (Node* e : emptyNodes) mark(e);
+
+        size_t survivors = 0;
+        for (Node& n : pool) {
+            if (n.level >= 0 && n.marked) survivors++;
+        }
+        size_t tableSize = 1 << 16;
+        while (tableSize < survivors) tableSize *= 2;
+        buckets.assign(tableSize, nullptr);
+        nodeCount = 0;
+        for (Node& n : pool) {
+            if (n.level < 0) continue;
+            if (!n.marked) {
+                n.level = -1;
+                n.result = nullptr;
+                n.chain = freeList;
+                freeList = &n;
+                continue;
+            }
+            if (n.result && !n.result->marked) {
+                n.result = nullptr;
+            }
+            insert(&n);
+            nodeCount++;
+        }
+        collections++;
+    }
+
+    void setMemoryLimit(size_t bytes) {
+        memoryLimit = bytes;
+    }
+
+    size_t getMemoryLimit() const {
+        return memoryLimit;
+    }
+
+    size_t getNodeCount() const {
+        return nodeCount;
+    }
+
+    uint64_t getCollections() const {
+        return collections;
+    }
+
+    // Approximate memory used by live nodes and the hash table (bytes)
+    size_t memoryUsage() const {
+        return nodeCount * sizeof(Node) + buckets.size() * sizeof(Node*);
+    }
+};
+
+// Ensemble class - many small packed worlds of one size and rule, evolved
+// together, e.g. for sweeps over seeds. The worlds are stored as a structure
+// of arrays. Generation counters, cycle periods and state-hash windows are
+// parallel arrays indexed by world. Cells are kept in groups of worlds laid
+// side by side: row y of a group is row y of each of its worlds, each
+// between two guard words, so the active row kernel evolves a whole group
+// row in one call however narrow the worlds are. Before each generation the
+// guards (and, for widths that are not a multiple of 64, the first padding
+// bit) are loaded with the cells across the world's wrap-around edge.
+//
+// A run is one parallel region in which a thread advances one group (sized
+// to stay in cache) through all generations of the run; worlds are
+// independent, so this equals advancing every world one generation at a
+// time. A world that enters a cycle is frozen and moved behind the group's
+// running worlds, so it costs nothing while the others continue.
+class Ensemble {
+private:
+    int width;
+    int height;
+    int nWords;                        // Words per world row
+    int rowWords;                      // Words per world row with its two guard words
+    size_t groupSize;                  // Worlds per group
+    size_t groupCount;
+    size_t count;                      // Number of worlds
+    LifeRule rule;
+    int maxCyclePeriod;                // Longest cycle a world is stopped on, 0 to never stop
+    std::vector<uint64_t> cells;       // Groups of two generations of height rows of groupSize world rows
+    std::vector<uint8_t> parity;       // Current generation of each group
+    std::vector<size_t> running;       // Running worlds of each group, in its first slots
+    std::vector<size_t> slotWorld;     // World in each slot (group * groupSize + position)
+    std::vector<size_t> worldSlot;     // Slot of each world
+    std::vector<uint64_t> generations; // Generation counter of each world
+    std::vector<int> periods;          // Period of the cycle world i stopped on, 0 while running
+    std::vector<StateHash> hashes;     // Ring of the last maxCyclePeriod state hashes of each world
+    std::vector<int> hashCounts;       // Valid entries of each ring
+
+    size_t groupStride() const {
+        return groupSize * static_cast<size_t>(rowWords);
+    }
+
+    // First word of group g's row y in generation buffer 'which'
+    uint64_t* groupRow(size_t g, int which, int y) {
+        return cells.data() + ((g * 2 + which) * height + y) * groupStride();
+    }
+
+    // First cell word of a slot's row y in generation buffer 'which'
+    uint64_t* slotRow(size_t slot, int which, int y) {
+        return groupRow(slot / groupSize, which, y) + (slot % groupSize) * rowWords + 1;
+    }
+
+    const uint64_t* slotRow(size_t slot, int which, int y) const {
+        return const_cast<Ensemble*>(this)->slotRow(slot, which, y);
+    }
+
+    // 128-bit hash of one world's generation (rows 'stride' words apart).
+    // The lanes of blockHash() run through all rows and are mixed once per
+    // world, as narrow rows would otherwise spend more time mixing than
+    // evolving.
+    StateHash worldHash(const uint64_t* rows, size_t stride) const {
+        uint64_t lo[4] = { 1, 2, 3, 4 };
+        uint64_t hi[4] = { 5, 6, 7, 8 };
+        for (int y = 0; y < height; y++) {
+            const uint64_t* words = rows + y * stride;
+            int w = 0;
+            for (; w + 4 <= nWords; w += 4) {
+                for (int k = 0; k < 4; k++) {
+                    lo[k] = (lo[k] ^ words[w + k]) * 0x9E3779B97F4A7C15ULL;
+                    hi[k] = ((hi[k] << 23) | (hi[k] >> 41)) + words[w + k];
+                }
+            }
+            for (; w < nWords; w++) {
+                lo[0] = (lo[0] ^ words[w]) * 0x9E3779B97F4A7C15ULL;
+                hi[0] = ((hi[0] << 23) | (hi[0] >> 41)) + words[w];
+            }
+        }
+        StateHash h;
+        h.lo = mix64(mix64(lo[0]) + lo[1] * 3 + lo[2] * 5 + lo[3] * 7);
+        h.hi = mix64(mix64(hi[0]) ^ mix64(hi[1] + hi[2] * 3 + hi[3] * 5));
+        return h;
+    }
+
+    // Compare world i's new state hash with its last maxCyclePeriod states,
+    // stop the world on a match and add the hash to its ring
+    void recordHash(size_t i, const StateHash& hash) {
+        StateHash* ring = hashes.data() + i * maxCyclePeriod;
+        uint64_t gen = generations[i];
+        for (int d = 1; d <= hashCounts[i]; d++) {
+            if (ring[(gen - d) % maxCyclePeriod] == hash) {
+                periods[i] = d;
+                break;
+            }
+        }
+        ring[gen % maxCyclePeriod] = hash;
+        hashCounts[i] = std::min(hashCounts[i] + 1, maxCyclePeriod);
+    }
+
+    // Swap the cells of two slots of a group in both generations
+    void swapSlots(size_t a, size_t b) {
+        for (int which = 0; which < 2; which++) {
+            for (int y = 0; y < height; y++) {
+                std::swap_ranges(slotRow(a, which, y), slotRow(a, which, y) + nWords, slotRow(b, which, y));
+            }
+        }
+        std::swap(slotWorld[a], slotWorld[b]);
+        worldSlot[slotWorld[a]] = a;
+        worldSlot[slotWorld[b]] = b;
+    }
+
+    // Advance the running worlds of group g by up to 'steps' generations;
+    // returns the number of world generations computed
+    uint64_t advanceGroup(size_t g, uint64_t steps, const EvolveKernel& kernel) {
+        int lastBits = width - (nWords - 1) * 64;
+        uint64_t lastMask = lastBits == 64 ? ~0ULL : ((1ULL << lastBits) - 1);
+        size_t first = g * groupSize;
+        std::vector<StateHash> stepHashes(groupSize);
+        uint64_t done = 0;
+        for (uint64_t step = 0; step < steps && running[g] > 0; step++) {
+            int current = parity[g];
+            size_t active = running[g];
+            // Guards: the cell west of column 0 in bit 63 of the west guard,
+            // the cell east of column width-1 in bit 0 of the east guard or
+            // in the first padding bit
+            for (int y = 0; y < height; y++) {
+                uint64_t* row = groupRow(g, current, y) + 1;
+                for (size_t k = 0; k < active; k++, row += rowWords) {
+                    row[-1] = row[nWords - 1] << (64 - lastBits);
+                    row[nWords] = row[0];
+                    if (lastBits < 64) row[nWords - 1] |= (row[0] & 1) << lastBits;
+                }
+            }
+
+            int span = static_cast<int>(active) * rowWords;
+            for (int y = 0; y < height; y++) {
+                const uint64_t* above = groupRow(g, current, (y + height - 1) % height);
+                const uint64_t* row = groupRow(g, current, y);
+                const uint64_t* below = groupRow(g, current, (y + 1) % height);
+                uint64_t* out = groupRow(g, current ^ 1, y);
+                kernel.row(above, row, below, out, 1, span - 1);
+                if (lastBits == 64) continue;
+                for (size_t k = 0; k < active; k++) {
+                    out[k * rowWords + nWords] &= lastMask;
+                }
+            }
+            if (maxCyclePeriod > 0) {
+                for (size_t k = 0; k < active; k++) {
+                    stepHashes[k] = worldHash(slotRow(first + k, current ^ 1, 0), groupStride());
+                }
+            }
+            parity[g] ^= 1;
+            done += active;
+
+            for (size_t k = active; k-- > 0;) {
+                size_t world = slotWorld[first + k];
+                generations[world]++;
+                if (maxCyclePeriod == 0) continue;
+                recordHash(world, stepHashes[k]);
+                if (periods[world] == 0) continue;
+                // Freeze the world: same cells in both generations, behind the running slots
+                for (int y = 0; y < height; y++) {
+                    const uint64_t* cellsNow = slotRow(first + k, current ^ 1, y);
+                    std::copy(cellsNow, cellsNow + nWords, slotRow(first + k, current, y));
+                }
+                running[g]--;
+                if (k != running[g]) swapSlots(first + k, first + running[g]);
+            }
+        }
+        return done;
+    }
+
+public:
+    Ensemble()
+        : width(0), height(0), nWords(0), rowWords(0), groupSize(0), groupCount(0), count(0), maxCyclePeriod(0) {}
+
+    // Replace the ensemble with n empty worlds; fails for Generations rules
+    bool reset(size_t n, int w, int h, const LifeRule& newRule, int period) {
+        if (newRule.isGenerations() || w <= 0 || h <= 0) return false;
+        width = w;
+        height = h;
+        nWords = (w + 63) / 64;
+        rowWords = nWords + 2;
+        count = n;
+        rule = newRule;
+        maxCyclePeriod = std::max(period, 0);
+
+        // Both generations of a group fit in 256 KB of cache where possible,
+        // with enough groups to balance the threads
+        size_t worldBytes = 2 * static_cast<size_t>(h) * rowWords * sizeof(uint64_t);
+        size_t threads = static_cast<size_t>(omp_get_max_threads());
+        groupSize = std::max<size_t>(1, std::min<size_t>((256 << 10) / worldBytes, 64));
+        groupSize = std::max<size_t>(1, std::min(groupSize, n / (4 * threads)));
+        groupCount = (n + groupSize - 1) / groupSize;
+
+        cells.assign(groupCount * 2 * h * groupStride(), 0);
+        parity.assign(groupCount, 0);
+        running.assign(groupCount, 0);
+        slotWorld.resize(groupCount * groupSize);
+        worldSlot.resize(n);
+        for (size_t s = 0; s < slotWorld.size(); s++) {
+            slotWorld[s] = s;
+            if (s < n) worldSlot[s] = s;
+        }
+        for (size_t g = 0; g < groupCount; g++) {
+            running[g] = std::min(groupSize, n - g * groupSize);
+        }
+        generations.assign(n, 0);
+        periods.assign(n, 0);
+        hashes.assign(n * maxCyclePeriod, StateHash());
+        hashCounts.assign(n, 0);
+        return true;
+    }
+
+    // Fill world i as 'fill <density> <seed + i>' fills a single world of the
+    // same size, so any member can be rebuilt on its own
+    void fillRandom(double density, uint64_t seed) {
+        int level = GameOfLife::densityLevel(density);
+        uint64_t lastMask = (width % 64 == 0) ? ~0ULL : ((1ULL << (width % 64)) - 1);
+        size_t worldWords = static_cast<size_t>(nWords) * height;
+        reset(count, width, height, rule, maxCyclePeriod);
+        #pragma omp parallel
+        {
+            std::vector<uint64_t> rows(worldWords);
+            #pragma omp for schedule(dynamic, 1)
+            for (int64_t i = 0; i < static_cast<int64_t>(count); i++) {
+                GameOfLife::randomWords(rows.data(), 0, static_cast<int64_t>(worldWords), nWords, lastMask, level,
+                                        seed + static_cast<uint64_t>(i), false);
+                for (int y = 0; y < height; y++) {
+                    const uint64_t* row = rows.data() + static_cast<size_t>(y) * nWords;
+                    std::copy(row, row + nWords, slotRow(i, 0, y));
+                }
+                if (maxCyclePeriod > 0) recordHash(i, worldHash(rows.data(), nWords));
+            }
+        }
+    }
+
+    // Advance every running world by up to 'steps' generations; returns the
+    // total number of world generations computed
+    uint64_t run(uint64_t steps) {
+        EvolveKernel kernel = KernelRegistry::resolve(rule);
+        uint64_t total = 0;
+        #pragma omp parallel for schedule(dynamic, 1) reduction(+:total)
+        for (int64_t g = 0; g < static_cast<int64_t>(groupCount); g++) {
+            total += advanceGroup(g, steps, kernel);
+        }
+        return total;
+    }
+
+    size_t size() const { return count; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    const LifeRule& getRule() const { return rule; }
+    int getMaxCyclePeriod() const { return maxCyclePeriod; }
+    uint64_t getGeneration(size_t i) const { return generations[i]; }
+
+    // Period of the cycle world i stopped on, 0 while it is still running
+    int getCyclePeriod(size_t i) const { return periods[i]; }
+
+    size_t stableCount() const {
+        return static_cast<size_t>(std::count_if(periods.begin(), periods.end(), [](int p) { return p > 0; }));
+    }
+
+    uint64_t getPopulation(size_t i) const {
+        size_t slot = worldSlot[i];
+        uint64_t population = 0;
+        for (int y = 0; y < height; y++) {
+            const uint64_t* row = slotRow(slot, parity[slot / groupSize], y);
+            for (int w = 0; w < nWords; w++) {
+                population += __builtin_popcountll(row[w]);
+            }
+        }
+        return population;
+    }
+
+    // Copy world i's current generation to packed rows (BitGrid layout)
+    void copyWorld(size_t i, uint64_t* out) const {
+        size_t slot = worldSlot[i];
+        for (int y = 0; y < height; y++) {
+            const uint64_t* row = slotRow(slot, parity[slot / groupSize], y);
+            std::copy(row, row + nWords, out + static_cast<size_t>(y) * nWords);
+        }
+    }
+};
+
+#ifdef GOL_MPI
+// DistributedWorld class - a packed toroidal world split into horizontal
+// strips across MPI ranks (domain decomposition), for worlds that do not fit
+// in one machine. Rank r owns rows [r * height / ranks, (r + 1) * height /
+// ranks) plus one halo row above and one below. Each generation the halo
+// messages to and from the neighbouring ranks are posted first, the interior
+// rows (which need no halo) are evolved while they are in flight, and the
+// two edge rows last. Row hashes use global row indices, so their sum over
+// all ranks (one reduction per generation) is the state hash a single
+// process computes, and every rank sees the same cycle at the same time.
+class DistributedWorld {
+private:
+    int rank;
+    int ranks;
+    int width;                      // Global size
+    int height;
+    int firstRow;                   // First global row owned by this rank
+    int rows;                       // Number of rows owned by this rank
+    int nWords;                     // Words per row
+    std::vector<uint64_t> grids[2]; // (rows + 2) x nWords: halo above, owned rows, halo below
+    int current;                    // Grid holding the current generation
+    uint64_t generation;
+    LifeRule rule;
+    KernelRegistry::RuleKind ruleKind; // Kernel kind of 'rule'
+    int maxCyclePeriod;             // Longest cycle the stability check looks for, 0 for none
+    int cyclePeriod;                // Period of the detected cycle, 0 if none
+    std::unordered_map<StateHash, uint64_t, StateHashHasher> seenStates;
+    std::deque<std::pair<StateHash, uint64_t>> seenOrder; // Seen states, oldest first
+    double haloWaitMs;              // Time spent waiting for halo rows in the last run
+    double reduceMs;                // Time spent in state hash reductions in the last run
+
+    uint64_t* row(int which, int local) {
+        return grids[which].data() + static_cast<size_t>(local) * nWords;
+    }
+
+    // Whether the condition holds on every rank; all ranks take the same branch
+    static bool everyRank(bool ok) {
+        int local = ok ? 1 : 0, all = 0;
+        MPI_Allreduce(&local, &all, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+        return all != 0;
+    }
+
+    // Allocate the strip of a width x height world owned by this rank
+    bool allocate(int w, int h) {
+        if (!everyRank(w > 0 && h >= ranks)) {
+            if (rank == 0) std::cerr << "Error: A distributed world needs at least one row per rank" << std::endl;
+            return false;
+        }
+        width = w;
+        height = h;
+        firstRow = static_cast<int>(static_cast<int64_t>(h) * rank / ranks);
+        rows = static_cast<int>(static_cast<int64_t>(h) * (rank + 1) / ranks) - firstRow;
+        nWords = (w + 63) / 64;
+        for (std::vector<uint64_t>& grid : grids) {
+            grid.assign(static_cast<size_t>(rows + 2) * nWords, 0);
+        }
+        current = 0;
+        generation = 0;
+        seenStates.clear();
+        seenOrder.clear();
+        cyclePeriod = 0;
+        return true;
+    }
+
+    // Sum of the hashes of the owned rows of a grid, over all ranks
+    StateHash reduceHash(uint64_t lo, uint64_t hi) {
+        double start = MPI_Wtime();
+        uint64_t local[2] = { lo, hi }, global[2] = { 0, 0 };
+        MPI_Allreduce(local, global, 2, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+        reduceMs += (MPI_Wtime() - start) * 1000;
+        StateHash hash;
+        hash.lo = global[0];
+        hash.hi = global[1];
+        return hash;
+    }
+
+    // Record the state hash of the current generation (see GameOfLife::detectCycle;
+    // there is no earlier generation to confirm a match against)
+    void detectCycle(const StateHash& hash) {
+        cyclePeriod = 0;
+        auto it = seenStates.find(hash);
+        if (it != seenStates.end() && generation - it->second <= static_cast<uint64_t>(maxCyclePeriod)) {
+            cyclePeriod = static_cast<int>(generation - it->second);
+        }
+        seenStates[hash] = generation;
+        seenOrder.emplace_back(hash, generation);
+        while (!seenOrder.empty() && generation - seenOrder.front().second > static_cast<uint64_t>(maxCyclePeriod)) {
+            auto old = seenStates.find(seenOrder.front().first);
+            if (old != seenStates.end() && old->second == seenOrder.front().second) {
+                seenStates.erase(old);
+            }
+            seenOrder.pop_front();
+        }
+    }
+
+    // Evolve the owned rows [begin, end) (local indices) of the current grid,
+    // adding their hashes to lo/hi
+    void evolveRows(int begin, int end, const EvolveKernel& kernel, uint64_t& lo, uint64_t& hi) {
+        int lastBits = width - (nWords - 1) * 64;
+        uint64_t lastMask = lastBits == 64 ? ~0ULL : ((1ULL << lastBits) - 1);
+        bool hashRows = maxCyclePeriod > 0;
+        uint64_t hashLo = 0, hashHi = 0;
+        #pragma omp parallel for schedule(static) reduction(+:hashLo,hashHi)
+        for (int y = begin; y < end; y++) {
+            uint64_t* out = row(current ^ 1, y);
+            evolvePackedRow(row(current, y - 1), row(current, y), row(current, y + 1), out,
+                            nWords, lastBits, lastMask, kernel);
+            if (hashRows) {
+                StateHash h = blockHash(out, nWords, static_cast<uint64_t>(firstRow + y - 1));
+                hashLo += h.lo;
+                hashHi += h.hi;
+            }
+        }
+        lo += hashLo;
+        hi += hashHi;
+    }
+
+public:
+    DistributedWorld(const LifeRule& worldRule, int period)
+        : width(0), height(0), firstRow(0), rows(0), nWords(0), current(0), generation(0), rule(worldRule),
+          ruleKind(KernelRegistry::kindOf(worldRule)), maxCyclePeriod(period), cyclePeriod(0), haloWaitMs(0), reduceMs(0) {
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+    }
+
+    // Start MPI on first use (the main thread makes every MPI call)
+    static void initialize() {
+        int initialized = 0;
+        MPI_Initialized(&initialized);
+        if (!initialized) {
+            int provided = 0;
+            MPI_Init_thread(nullptr, nullptr, MPI_THREAD_FUNNELED, &provided);
+        }
+    }
+
+    static void barrier() {
+        MPI_Barrier(MPI_COMM_WORLD);
+    }
+
+    static void finalize() {
+        int initialized = 0, finalized = 0;
+        MPI_Initialized(&initialized);
+        MPI_Finalized(&finalized);
+        if (initialized && !finalized) MPI_Finalize();
+    }
+
+    // Create the strip of a random world: the same cells as
+    // GameOfLife::fillRandom() on the whole world
+    bool fill(int w, int h, double density, uint64_t seed) {
+        if (!allocate(w, h)) return false;
+        uint64_t lastMask = (w % 64 == 0) ? ~0ULL : ((1ULL << (w % 64)) - 1);
+        GameOfLife::randomWords(row(current, 1), static_cast<int64_t>(firstRow) * nWords,
+                                static_cast<int64_t>(rows) * nWords, nWords, lastMask,
+                                GameOfLife::densityLevel(density), seed);
+        return true;
+    }
+
+    // Read this rank's rows of a binary world file; only the blocks that
+    // overlap the strip are touched (and decoded, for RLE files)
+    bool load(const std::string& filename) {
+        MappedFile mapped;
+        BinaryWorldHeader header;
+        bool ok = mapped.open(filename) && mapped.size() >= sizeof(header);
+        if (ok) {
+            std::memcpy(&header, mapped.data(), sizeof(header));
+            ok = std::memcmp(header.magic, binaryWorldMagic, sizeof(header.magic)) == 0 && header.version == 1 &&
+                 header.width > 0 && header.height > 0 && header.rowsPerBlock > 0 &&
+                 header.width <= 0x7FFFFFFFu && header.height <= 0x7FFFFFFFu;
+        }
+        std::vector<size_t> offsets;
+        const uint64_t* data = nullptr;
+        if (ok) {
+            data = reinterpret_cast<const uint64_t*>(mapped.data() + sizeof(header));
+            ok = binaryBlockOffsets(header, data, (mapped.size() - sizeof(header)) / sizeof(uint64_t), offsets);
+        }
+        if (!everyRank(ok)) {
+            if (rank == 0) std::cerr << "Error: Could not read binary world file " << filename << std::endl;
+            return false;
+        }
+        if (!allocate(static_cast<int>(header.width), static_cast<int>(header.height))) return false;
+        generation = header.generation;
+
+        int rowsPerBlock = static_cast<int>(std::min(header.rowsPerBlock, header.height));
+        int firstBlock = firstRow / rowsPerBlock;
+        int lastBlock = (firstRow + rows - 1) / rowsPerBlock;
+        bool valid = true;
+        #pragma omp parallel for schedule(static) reduction(&&:valid)
+        for (int b = firstBlock; b <= lastBlock; b++) {
+            int y0 = b * rowsPerBlock;
+            int blockRows = std::min(rowsPerBlock, height - y0);
+            const uint64_t* words = data + offsets[b];
+            std::vector<uint64_t> decoded;
+            if (header.flags & binaryWorldRLE) {
+                decoded.resize(static_cast<size_t>(blockRows) * nWords);
+                valid = decodeWordsRLE(words + 1, offsets[b + 1] - offsets[b] - 1, decoded.data(), decoded.size()) && valid;
+                words = decoded.data();
+            }
+            int begin = std::max(y0, firstRow), end = std::min(y0 + blockRows, firstRow + rows);
+            for (int y = begin; y < end && valid; y++) {
+                const uint64_t* source = words + static_cast<size_t>(y - y0) * nWords;
+                std::copy(source, source + nWords, row(current, y - firstRow + 1));
+            }
+        }
+        // Padding bits past the width must stay zero
+        uint64_t lastMask = (width % 64 == 0) ? ~0ULL : ((1ULL << (width % 64)) - 1);
+        for (int y = 1; y <= rows; y++) {
+            row(current, y)[nWords - 1] &= lastMask;
+        }
+        if (!everyRank(valid)) {
+            if (rank == 0) std::cerr << "Error: Corrupt world file " << filename << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Write the world as an uncompressed binary world file; every rank
+    // writes its own rows at their offset (MPI-IO), rank 0 the header
+    bool save(const std::string& filename) {
+        MPI_File file;
+        if (MPI_File_open(MPI_COMM_WORLD, filename.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY,
+                          MPI_INFO_NULL, &file) != MPI_SUCCESS) {
+            if (rank == 0) std::cerr << "Error: Could not open file " << filename << std::endl;
+            return false;
+        }
+        bool ok = MPI_File_set_size(file, 0) == MPI_SUCCESS;
+        if (rank == 0) {
+            BinaryWorldHeader header;
+            std::memcpy(header.magic, binaryWorldMagic, sizeof(header.magic));
+            header.version = 1;
+            header.flags = 0;
+            header.width = static_cast<uint32_t>(width);
+            header.height = static_cast<uint32_t>(height);
+            header.storage = static_cast<uint32_t>(GameOfLife::Storage::Packed);
+            header.rowsPerBlock = 64; // Raw rows read the same with any block size
+            header.generation = generation;
+            ok = ok && MPI_File_write_at(file, 0, &header, sizeof(header), MPI_BYTE, MPI_STATUS_IGNORE) == MPI_SUCCESS;
+        }
+        // Counts are ints, so large strips go out in pieces
+        const size_t piece = size_t(1) << 26;
+        size_t total = static_cast<size_t>(rows) * nWords;
+        MPI_Offset base = static_cast<MPI_Offset>(sizeof(BinaryWorldHeader)) +
+                          static_cast<MPI_Offset>(firstRow) * nWords * static_cast<MPI_Offset>(sizeof(uint64_t));
+        for (size_t done = 0; done < total && ok; done += piece) {
+            int count = static_cast<int>(std::min(piece, total - done));
+            ok = MPI_File_write_at(file, base + static_cast<MPI_Offset>(done * sizeof(uint64_t)), row(current, 1) + done,
+                                   count, MPI_UINT64_T, MPI_STATUS_IGNORE) == MPI_SUCCESS;
+        }
+        MPI_File_close(&file);
+        if (!everyRank(ok)) {
+            if (rank == 0) std::cerr << "Error: Could not write file " << filename << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Advance one generation: post the halo exchange, evolve the interior
+    // while it is in flight, then the two edge rows
+    void step() {
+        EvolveKernel kernel = KernelRegistry::resolve(ruleKind, rule);
+        int up = (rank + ranks - 1) % ranks;
+        int down = (rank + 1) % ranks;
+        // Tag 0 carries a last row down to the next rank, tag 1 a first row up
+        MPI_Request requests[4];
+        MPI_Irecv(row(current, 0), nWords, MPI_UINT64_T, up, 0, MPI_COMM_WORLD, &requests[0]);
+        MPI_Irecv(row(current, rows + 1), nWords, MPI_UINT64_T, down, 1, MPI_COMM_WORLD, &requests[1]);
+        MPI_Isend(row(current, rows), nWords, MPI_UINT64_T, down, 0, MPI_COMM_WORLD, &requests[2]);
+        MPI_Isend(row(current, 1), nWords, MPI_UINT64_T, up, 1, MPI_COMM_WORLD, &requests[3]);
+
+        uint64_t lo = 0, hi = 0;
+        evolveRows(2, rows, kernel, lo, hi);
+
+        double start = MPI_Wtime();
+        MPI_Waitall(4, requests, MPI_STATUSES_IGNORE);
+        haloWaitMs += (MPI_Wtime() - start) * 1000;
+        evolveRows(1, 2, kernel, lo, hi);
+        if (rows > 1) evolveRows(rows, rows + 1, kernel, lo, hi);
+
+        current ^= 1;
+        generation++;
+        if (maxCyclePeriod > 0) detectCycle(reduceHash(lo, hi));
+    }
+
+    // Run up to 'generations' steps, stopping when the world enters a cycle
+    // (on every rank at once); returns the number of generations run
+    uint64_t run(uint64_t generations) {
+        haloWaitMs = 0;
+        reduceMs = 0;
+        // A fresh history starts with the state we evolve from
+        if (maxCyclePeriod > 0 && seenOrder.empty()) {
+            StateHash local;
+            for (int y = 1; y <= rows; y++) {
+                local += blockHash(row(current, y), nWords, static_cast<uint64_t>(firstRow + y - 1));
+            }
+            detectCycle(reduceHash(local.lo, local.hi));
+        }
+        uint64_t done = 0;
+        while (done < generations && cyclePeriod == 0) {
+            step();
+            done++;
+        }
+        return done;
+    }
+
+    // Live cells of the whole world
+    uint64_t population() {
+        uint64_t local = 0, global = 0;
+        for (int y = 1; y <= rows; y++) {
+            const uint64_t* words = row(current, y);
+            for (int w = 0; w < nWords; w++) {
+                local += __builtin_popcountll(words[w]);
+            }
+        }
+        MPI_Allreduce(&local, &global, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+        return global;
+    }
+
+    int getRank() const { return rank; }
+    int getRanks() const { return ranks; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    uint64_t getGeneration() const { return generation; }
+    int getCyclePeriod() const { return cyclePeriod; }
+
+    // Halo wait and reduction time of the last run on this rank (ms)
+    double getHaloWaitMs() const { return haloWaitMs; }
+    double getReduceMs() const { return reduceMs; }
+};
+#endif
+
+// TerminalRenderer class - draws a viewport of the world into the terminal.
+// Each glyph covers a block of dots (1x1, 1x2 half blocks or 2x4 braille)
+// and each dot a zoom x zoom block of cells, alive if any of them is. Only
+// glyphs that differ from the last frame are rewritten, using cursor
+// addressing, and a frame goes out as one buffered write. The simulation
+// samples frames into a lock-free triple buffer; a render thread draws the
+// newest one at the frame rate limit, so stale frames are dropped and the
+// terminal never stalls the simulation.
+class TerminalRenderer {
+public:
+    enum class Glyphs { Classic, Block, HalfBlock, Braille };
+
+private:
+    Glyphs glyphs;
+    int64_t viewX;                 // World cell at the top-left corner
+    int64_t viewY;
+    int zoom;                      // Cells per dot along each axis
+    int maxFps;                    // Frame rate limit, 0 for none
+    std::vector<uint32_t> shown;   // Code point on screen per glyph, 0 if unknown
+    int shownColumns;
+    int shownRows;
+    std::string text;              // Escape sequences and text of a frame
+    std::vector<uint64_t> rowWords;
+    std::vector<uint64_t> dotWords;
+    bool active;
+
+    int dotsX() const { return glyphs == Glyphs::Braille ? 2 : 1; }
+    int dotsY() const { return glyphs == Glyphs::Braille ? 4 : (glyphs == Glyphs::HalfBlock ? 2 : 1); }
+    int glyphWidth() const { return glyphs == Glyphs::Classic ? 2 : 1; }
+
+    // Terminal size in characters
+    static void terminalSize(int& columns, int& rows) {
+        columns = 80;
+        rows = 24;
+#if defined(GOL_HAVE_MMAP) && defined(TIOCGWINSZ)
+        struct winsize size;
+        if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_col > 0 && size.ws_row > 0) {
+            columns = size.ws_col;
+            rows = size.ws_row;
+            return;
+        }
+#endif
+        if (const char* env = std::getenv("COLUMNS")) columns = std::max(1, std::atoi(env));
+        if (const char* env = std::getenv("LINES")) rows = std::max(2, std::atoi(env));
+    }
+
+    // Whether any of bits [begin, begin + count) of words[] is set
+    static bool anyBits(const std::vector<uint64_t>& words, int64_t begin, int count) {
+        if (count == 1) return (words[begin >> 6] >> (begin & 63)) & 1;
+        for (int64_t x = begin, end = begin + count; x < end;) {
+            int bit = static_cast<int>(x & 63);
+            int take = static_cast<int>(std::min<int64_t>(64 - bit, end - x));
+            uint64_t mask = (take == 64) ? ~0ULL : (((1ULL << take) - 1) << bit);
+            if (words[x >> 6] & mask) return true;
+            x += take;
+        }
+        return false;
+    }
+
+    static void appendUtf8(std::string& out, uint32_t code) {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    // Code point for a glyph from its dot bits (bit dy * 2 + dx)
+    uint32_t glyphFor(unsigned dots) const {
+        switch (glyphs) {
+            case Glyphs::Classic: return dots ? 0x25A0 : 0x25A1;   // ■ □
+            case Glyphs::Block: return dots ? 0x2588 : ' ';        // █
+            case Glyphs::HalfBlock: {
+                static const uint32_t halves[4] = { ' ', 0x2580, 0x2584, 0x2588 }; // ▀ ▄ █
+                return halves[(dots & 1) | ((dots >> 1) & 2)]; // Top dot is bit 0, bottom bit 2
+            }
+            case Glyphs::Braille: {
+                // Braille dot numbering: left column 1,2,3,7 and right column 4,5,6,8
+                static const unsigned order[8] = { 0x01, 0x08, 0x02, 0x10, 0x04, 0x20, 0x40, 0x80 };
+                unsigned bits = 0;
+                for (int i = 0; i < 8; i++) {
+                    if (dots & (1u << i)) bits |= order[i];
+                }
+                return 0x2800 + bits;
+            }
+        }
+        return ' ';
+    }
+
+public:
+    TerminalRenderer()
+        : glyphs(Glyphs::Classic), viewX(0), viewY(0), zoom(1), maxFps(30),
+          shownColumns(0), shownRows(0), active(false), latest(1), back(0), front(2),
+          stopping(false), published(false), shownGlyphWidth(0) {}
+
+    TerminalRenderer(const TerminalRenderer&) = delete;
+    TerminalRenderer& operator=(const TerminalRenderer&) = delete;
+
+    static bool parseGlyphs(const std::string& name, Glyphs& result) {
+        if (name == "classic") result = Glyphs::Classic;
+        else if (name == "block") result = Glyphs::Block;
+        else if (name == "half") result = Glyphs::HalfBlock;
+        else if (name == "braille") result = Glyphs::Braille;
+        else return false;
+        return true;
+    }
+
+    static const char* glyphsName(Glyphs glyphs) {
+        switch (glyphs) {
+            case Glyphs::Classic: return "classic";
+            case Glyphs::Block: return "block";
+            case Glyphs::HalfBlock: return "half";
+            case Glyphs::Braille: return "braille";
+        }
+        return "unknown";
+    }
+
+    void setGlyphs(Glyphs value) {
+        glyphs = value;
+    }
+
+    Glyphs getGlyphs() const { return glyphs; }
+
+    void setView(int64_t x, int64_t y, int cellsPerDot) {
+        viewX = x;
+        viewY = y;
+        zoom = std::max(1, cellsPerDot);
+    }
+
+    int64_t getViewX() const { return viewX; }
+    int64_t getViewY() const { return viewY; }
+    int getZoom() const { return zoom; }
+
+    // Pick the origin and zoom showing the whole world (the live area of an
+    // unbounded world) in the current terminal
+    void fit(const GameOfLife& world) {
+        int columns, rows;
+        terminalSize(columns, rows);
+        int64_t minX = 0, minY = 0, maxX = world.getWidth() - 1, maxY = world.getHeight() - 1;
+        if (!world.isBounded() && !world.getLiveBounds(minX, minY, maxX, maxY)) {
+            minX = minY = maxX = maxY = 0;
+        }
+        int64_t dotColumns = static_cast<int64_t>(columns / glyphWidth()) * dotsX();
+        int64_t dotRows = static_cast<int64_t>(std::max(1, rows - 1)) * dotsY();
+        int64_t fitX = (maxX - minX + dotColumns) / dotColumns;
+        int64_t fitY = (maxY - minY + dotRows) / dotRows;
+        setView(minX, minY, static_cast<int>(std::min<int64_t>(std::max(fitX, fitY), 1 << 20)));
+    }
+
+    void setMaxFps(int fps) { maxFps = std::max(0, fps); }
+    int getMaxFps() const { return maxFps; }
+
+    // Switch to the alternate screen and start the render thread; the first
+    // frame is drawn in full
+    void begin() {
+        std::cout << "\033[?1049h\033[?25l" << std::flush;
+        shownColumns = shownRows = shownGlyphWidth = 0;
+        latest.store(1);
+        back = 0;
+        front = 2;
+        stopping.store(false);
+        published = false;
+        thread = std::thread(&TerminalRenderer::renderLoop, this);
+        active = true;
+    }
+
+    // Stop the render thread once it has drawn the last published frame,
+    // then restore the normal screen and cursor
+    void end() {
+        if (!active) return;
+        stopping.store(true);
+        thread.join();
+        std::cout << "\033[?25h\033[?1049l" << std::flush;
+        active = false;
+    }
+
+    // Whether the frame rate limit allows publishing a frame now
+    bool frameDue() const {
+        if (maxFps == 0 || !published) return true;
+        return std::chrono::steady_clock::now() - lastPublish >= std::chrono::microseconds(1000000 / maxFps);
+    }
+
+    // Sample the world into the back frame and hand it to the render thread
+    // (simulation thread only). A frame the render thread has not picked up
+    // yet is replaced, i.e. dropped.
+    void publish(const GameOfLife& world, const std::string& status) {
+        sample(world, status, frames[back]);
+        back = latest.exchange(back | freshFrame) & frameIndex;
+        published = true;
+        lastPublish = std::chrono::steady_clock::now();
+    }
+
+    ~TerminalRenderer() {
+        end();
+    }
+
+private:
+    // Glyph codes of one frame; owned by one side of the triple buffer at a time
+    struct Frame {
+        std::string status;
+        int columns = 0;
+        int rows = 0;
+        int glyphWidth = 1;
+        std::vector<uint32_t> codes;
+    };
+
+    static constexpr unsigned frameIndex = 3;
+    static constexpr unsigned freshFrame = 4;
+
+    // Triple buffer: the simulation fills frames[back], the render thread
+    // draws frames[front], and 'latest' holds the index of the third frame
+    // plus freshFrame while it is newer than the one drawn last
+    Frame frames[3];
+    std::atomic<unsigned> latest;
+    unsigned back;
+    unsigned front;
+    std::atomic<bool> stopping;
+    std::thread thread;
+    bool published;
+    std::chrono::steady_clock::time_point lastPublish;
+    int shownGlyphWidth;
+
+    // Render thread: draw the newest frame at most maxFps times per second
+    void renderLoop() {
+        while (true) {
+            bool last = stopping.load();
+            if (latest.load() & freshFrame) {
+                front = latest.exchange(front) & frameIndex;
+                present(frames[front]);
+            }
+            if (last) return;
+            std::this_thread::sleep_for(std::chrono::microseconds(maxFps > 0 ? 1000000 / maxFps : 1000));
+        }
+    }
+
+    // Glyph codes for the viewport of the world below a status line
+    void sample(const GameOfLife& world, const std::string& status, Frame& out) {
+        int columns, rows;
+        terminalSize(columns, rows);
+        int gw = glyphWidth(), dx = dotsX(), dy = dotsY();
+        int64_t cellsPerGlyphX = static_cast<int64_t>(dx) * zoom, cellsPerGlyphY = static_cast<int64_t>(dy) * zoom;
+        int64_t glyphColumns = columns / gw;
+        int64_t glyphRows = std::max(1, rows - 1);
+        if (world.isBounded()) {
+            // No glyphs past the edges of a bounded world
+            glyphColumns = std::min<int64_t>(glyphColumns, std::max<int64_t>(0, (world.getWidth() - viewX + cellsPerGlyphX - 1) / cellsPerGlyphX));
+            glyphRows = std::min<int64_t>(glyphRows, std::max<int64_t>(0, (world.getHeight() - viewY + cellsPerGlyphY - 1) / cellsPerGlyphY));
+        }
+        out.status = status;
+        out.columns = static_cast<int>(glyphColumns);
+        out.rows = static_cast<int>(glyphRows);
+        out.glyphWidth = gw;
+        out.codes.resize(static_cast<size_t>(out.columns) * out.rows);
+
+        // Source words covering the viewport columns (bit 'offset' is viewX)
+        int64_t firstWord = (viewX >= 0) ? viewX / 64 : -((-viewX + 63) / 64);
+        int64_t offset = viewX - firstWord * 64;
+        int words = static_cast<int>((offset + out.columns * cellsPerGlyphX + 63) / 64);
+        rowWords.assign(words, 0);
+        dotWords.assign(static_cast<size_t>(words) * dy, 0);
+
+        for (int r = 0; r < out.rows; r++) {
+            // OR the zoom source rows of each dot row together
+            std::fill(dotWords.begin(), dotWords.end(), 0);
+            for (int j = 0; j < dy; j++) {
+                for (int k = 0; k < zoom; k++) {
+                    int64_t y = viewY + (static_cast<int64_t>(r) * dy + j) * zoom + k;
+                    world.getRowWords(y, firstWord, words, rowWords.data());
+                    for (int w = 0; w < words; w++) dotWords[static_cast<size_t>(j) * words + w] |= rowWords[w];
+                }
+            }
+            for (int c = 0; c < out.columns; c++) {
+                unsigned dots = 0;
+                for (int j = 0; j < dy; j++) {
+                    for (int i = 0; i < dx; i++) {
+                        int64_t begin = static_cast<int64_t>(j) * words * 64 + offset + (static_cast<int64_t>(c) * dx + i) * zoom;
+                        if (anyBits(dotWords, begin, zoom)) dots |= 1u << (j * 2 + i);
+                    }
+                }
+                out.codes[static_cast<size_t>(r) * out.columns + c] = glyphFor(dots);
+            }
+        }
+    }
+
+    // Write the glyphs that differ from the screen (render thread only)
+    void present(const Frame& in) {
+        text.clear();
+        if (in.columns != shownColumns || in.rows != shownRows || in.glyphWidth != shownGlyphWidth) {
+            // Size or layout changed: start from a blank screen
+            text += "\033[2J";
+            shown.assign(in.codes.size(), 0);
+            shownColumns = in.columns;
+            shownRows = in.rows;
+            shownGlyphWidth = in.glyphWidth;
+        }
+        text += "\033[1;1H";
+        text += in.status;
+        text += "\033[K";
+
+        int cursorRow = -1, cursorColumn = -1;
+        for (int r = 0; r < in.rows; r++) {
+            for (int c = 0; c < in.columns; c++) {
+                uint32_t code = in.codes[static_cast<size_t>(r) * in.columns + c];
+                uint32_t& old = shown[static_cast<size_t>(r) * in.columns + c];
+                if (old == code) continue;
+                old = code;
+                if (cursorRow != r || cursorColumn != c) {
+                    text += "\033[" + std::to_string(r + 2) + ";" + std::to_string(c * in.glyphWidth + 1) + "H";
+                }
+                appendUtf8(text, code);
+                if (in.glyphWidth == 2) text += ' ';
+                cursorRow = r;
+                cursorColumn = c + 1;
+            }
+        }
+        std::cout.write(text.data(), static_cast<std::streamsize>(text.size()));
+        std::cout.flush();
+    }
+};
+
+// Recording log layout: a RecordingHeader, then frames of one
+// RecordingFrameHeader followed by 'words' RLE tokens (see encodeWordsRLE).
+// A keyframe encodes the packed rows of its generation, a delta frame the
+// XOR of its rows with the previous frame's, so unchanged areas collapse
+// into zero runs. Frames are only ever appended.
+struct RecordingHeader {
+    char magic[8];             // recordingMagic
+    uint32_t version;          // Format version, currently 1
+    uint32_t storage;          // GameOfLife::Storage of the recorded world
+    uint32_t width;            // Cells per row
+    uint32_t height;           // Number of rows
+    uint64_t keyframeInterval; // Frames between keyframes
+};
+
+struct RecordingFrameHeader {
+    uint32_t keyframe;   // 1 for a keyframe, 0 for a delta frame
+    uint32_t reserved;
+    uint64_t generation; // Generation the frame reconstructs
+    uint64_t words;      // Number of RLE tokens that follow
+};
+
+static const char recordingMagic[8] = { 'G', 'O', 'L', 'R', 'E', 'C', '\r', '\n' };
+
+// RunRecorder class - appends one frame per recorded generation
+class RunRecorder {
+private:
+    std::ofstream file;
+    std::string path;
+    int width;
+    int height;
+    uint64_t keyframeInterval;
+    uint64_t sinceKeyframe;          // Delta frames written since the last keyframe
+    uint64_t lastGeneration;
+    bool hasFrame;
+    std::vector<uint64_t> previous;  // Packed rows of the last frame
+    std::vector<uint64_t> current;   // Packed rows of the frame being written
+    std::vector<uint64_t> encoded;
+    uint64_t frames;
+    uint64_t keyframes;
+    uint64_t bytes;
+
+public:
+    RunRecorder()
+        : width(0), height(0), keyframeInterval(0), sinceKeyframe(0), lastGeneration(0), hasFrame(false),
+          frames(0), keyframes(0), bytes(0) {}
+
+    bool isOpen() const {
+        return file.is_open();
+    }
+
+    // Start a recording of 'world'; its current generation is the first keyframe
+    bool open(const std::string& filename, const GameOfLife& world, uint64_t interval) {
+        close();
+        file.open(filename, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not open file " << filename << std::endl;
+            return false;
+        }
+        path = filename;
+        width = world.getWidth();
+        height = world.getHeight();
+        keyframeInterval = interval;
+        hasFrame = false;
+        frames = keyframes = bytes = 0;
+        size_t words = static_cast<size_t>(height) * ((width + 63) / 64);
+        previous.assign(words, 0);
+        current.assign(words, 0);
+
+        RecordingHeader header;
+        std::memcpy(header.magic, recordingMagic, sizeof(header.magic));
+        header.version = 1;
+        header.storage = static_cast<uint32_t>(world.getStorage());
+        header.width = static_cast<uint32_t>(width);
+        header.height = static_cast<uint32_t>(height);
+        header.keyframeInterval = keyframeInterval;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        bytes += sizeof(header);
+        return append(world);
+    }
+
+    // Append the world's current generation. Delta frames follow consecutive
+    // generations; a gap (e.g. after a HashLife jump) or the keyframe
+    // interval starts a new keyframe.
+    bool append(const GameOfLife& world) {
+        if (!file.is_open()) return false;
+        if (world.getWidth() != width || world.getHeight() != height) {
+            std::cout << "World size changed; recording to " << path << " stopped." << std::endl;
+            close();
+            return false;
+        }
+        world.packGeneration(current.data());
+        bool keyframe = !hasFrame || world.getGeneration() != lastGeneration + 1 || sinceKeyframe + 1 >= keyframeInterval;
+        if (!keyframe) {
+            // XOR against the previous frame, in place: 'previous' becomes the delta
+            size_t count = current.size();
+            #pragma omp parallel for schedule(static)
+            for (size_t i = 0; i < count; i++) {
+                previous[i] ^= current[i];
+            }
+        }
+        encoded.clear();
+        encodeWordsRLE(keyframe ? current.data() : previous.data(), current.size(), encoded);
+
+        RecordingFrameHeader frame;
+        frame.keyframe = keyframe ? 1 : 0;
+        frame.reserved = 0;
+        frame.generation = world.getGeneration();
+        frame.words = encoded.size();
+        file.write(reinterpret_cast<const char*>(&frame), sizeof(frame));
+        file.write(reinterpret_cast<const char*>(encoded.data()), encoded.size() * sizeof(uint64_t));
+        if (keyframe) file.flush(); // A crash loses at most one keyframe interval
+        if (!file.good()) {
+            std::cerr << "Error: Could not write file " << path << std::endl;
+            close();
+            return false;
+        }
+
+        std::swap(previous, current);
+        hasFrame = true;
+        lastGeneration = world.getGeneration();
+        sinceKeyframe = keyframe ? 0 : sinceKeyframe + 1;
+        frames++;
+        if (keyframe) keyframes++;
+        bytes += sizeof(frame) + encoded.size() * sizeof(uint64_t);
+        return true;
+    }
+
+    void close() {
+        if (file.is_open()) file.close();
+    }
+
+    void printStatus() const {
+        std::cout << (file.is_open() ? "Recording to " + path : std::string("Not recording")) << std::endl;
+        if (frames > 0) {
+            size_t raw = current.size() * sizeof(uint64_t);
+            std::cout << "Frames: " << frames << " (" << keyframes << " keyframes), " << bytes << " bytes written, "
+                      << static_cast<double>(bytes) / frames << " bytes/frame vs " << raw << " per full grid" << std::endl;
+        }
+    }
+};
+
+// RunReplay class - reconstructs generations from a recording. The log is
+// memory-mapped and indexed by one pass over the frame headers; a frame is
+// rebuilt from the nearest keyframe at or before it.
+class RunReplay {
+public:
+    struct Frame {
+        uint64_t generation;
+        bool keyframe;
+        const uint64_t* tokens;
+        size_t words;
+    };
+
+private:
+    MappedFile mapped;
+    RecordingHeader header;
+    std::vector<Frame> frames;
+    std::vector<uint64_t> grid;   // Packed rows of frame 'position'
+    std::vector<uint64_t> delta;
+    size_t position;              // Frame held in grid, frames.size() if none
+
+    // Apply frame i on top of grid (which must hold frame i - 1 for a delta)
+    bool applyFrame(size_t i) {
+        const Frame& frame = frames[i];
+        if (frame.keyframe) {
+            if (!decodeWordsRLE(frame.tokens, frame.words, grid.data(), grid.size())) return false;
+        } else {
+            if (!decodeWordsRLE(frame.tokens, frame.words, delta.data(), delta.size())) return false;
+            size_t count = grid.size();
+            #pragma omp parallel for schedule(static)
+            for (size_t w = 0; w < count; w++) {
+                grid[w] ^= delta[w];
+            }
+        }
+        position = i;
+        return true;
+    }
+
+public:
+    RunReplay() : position(0) {}
+
+    // Map and index a recording; a truncated last frame is ignored
+    bool open(const std::string& filename) {
+        frames.clear();
+        if (!mapped.open(filename)) {
+            std::cerr << "Error: Could not open file " << filename << std::endl;
+            return false;
+        }
+        if (mapped.size() < sizeof(header) ||
+            std::memcmp(mapped.data(), recordingMagic, sizeof(recordingMagic)) != 0) {
+            std::cerr << "Error: Not a recording: " << filename << std::endl;
+            return false;
+        }
+        std::memcpy(&header, mapped.data(), sizeof(header));
+        if (header.version != 1 || header.width == 0 || header.height == 0 ||
+            header.width > 0x7FFFFFFFu || header.height > 0x7FFFFFFFu ||
+            header.storage > static_cast<uint32_t>(GameOfLife::Storage::Sparse)) {
+            std::cerr << "Error: Unsupported recording " << filename << std::endl;
+            return false;
+        }
+
+        size_t offset = sizeof(header);
+        while (offset + sizeof(RecordingFrameHeader) <= mapped.size()) {
+            RecordingFrameHeader frame;
+            std::memcpy(&frame, mapped.data() + offset, sizeof(frame));
+            offset += sizeof(frame);
+            if (frame.words > (mapped.size() - offset) / sizeof(uint64_t)) break;
+            if (frames.empty() && !frame.keyframe) break;
+            frames.push_back(Frame{ frame.generation, frame.keyframe != 0,
+                                    reinterpret_cast<const uint64_t*>(mapped.data() + offset),
+                                    static_cast<size_t>(frame.words) });
+            offset += frame.words * sizeof(uint64_t);
+        }
+        if (frames.empty()) {
+            std::cerr << "Error: Recording " << filename << " has no frames" << std::endl;
+            return false;
+        }
+        size_t words = static_cast<size_t>(header.height) * ((header.width + 63) / 64);
+        grid.assign(words, 0);
+        delta.assign(words, 0);
+        position = frames.size();
+        return true;
+    }
+
+    bool isOpen() const {
+        return !frames.empty();
+    }
+
+    const std::vector<Frame>& getFrames() const {
+        return frames;
+    }
+
+    int getWidth() const { return static_cast<int>(header.width); }
+    int getHeight() const { return static_cast<int>(header.height); }
+    GameOfLife::Storage getStorage() const { return static_cast<GameOfLife::Storage>(header.storage); }
+
+    // Index of the last frame recording generation gen, or frames.size()
+    size_t findFrame(uint64_t gen) const {
+        for (size_t i = frames.size(); i-- > 0;) {
+            if (frames[i].generation == gen) return i;
+        }
+        return frames.size();
+    }
+
+    // Rebuild frame i: step forward from the frame held now when that is
+    // cheaper, otherwise start over at the nearest keyframe
+    bool seek(size_t i) {
+        size_t key = i;
+        while (!frames[key].keyframe) key--;
+        size_t from = (position < frames.size() && position <= i && position >= key) ? position + 1 : key;
+        for (size_t f = from; f <= i; f++) {
+            if (!applyFrame(f)) {
+                position = frames.size();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Packed rows of the frame last reached with seek()
+    const uint64_t* rows() const {
+        return grid.data();
+    }
+};
+
+// MetricsStream class - writes the metrics of every n-th generation of a run
+// as one CSV or JSON line each, to a file or a named pipe. Lines are flushed
+// at most every 50 ms and at the end of a run, so a reader sees them live.
+class MetricsStream {
+private:
+    std::ofstream file;
+    std::string path;
+    bool json;
+    uint64_t interval;
+    uint64_t lines;
+    uint64_t lastGeneration;                          // Generation of the last line (or run start)
+    std::chrono::steady_clock::time_point lastTime;   // and when it was reached
+    std::chrono::steady_clock::time_point lastFlush;
+
+public:
+    MetricsStream() : json(false), interval(0), lines(0), lastGeneration(0) {}
+
+    bool isOpen() const {
+        return file.is_open();
+    }
+
+    uint64_t getInterval() const {
+        return interval;
+    }
+
+    bool open(const std::string& filename, uint64_t every, bool asJson) {
+        close();
+        file.open(filename, std::ios::out | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not open file " << filename << std::endl;
+            return false;
+        }
+        path = filename;
+        json = asJson;
+        interval = every;
+        lines = 0;
+        if (!json) {
+            file << "generation,population,births,deaths,min_x,min_y,max_x,max_y,active,generations_per_second\n";
+        }
+        lastFlush = std::chrono::steady_clock::now();
+        return true;
+    }
+
+    // A run starts at 'generation'; its first line's rate is measured from here
+    void beginRun(uint64_t generation) {
+        lastGeneration = generation;
+        lastTime = std::chrono::steady_clock::now();
+    }
+
+    bool write(const GenerationMetrics& m) {
+        if (!file.is_open()) return false;
+        auto now = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(now - lastTime).count();
+        double rate = seconds > 0 ? static_cast<double>(m.generation - lastGeneration) / seconds : 0;
+        bool empty = m.minX > m.maxX;
+        if (json) {
+            file << "{\"generation\": " << m.generation << ", \"population\": " << m.population
+                 << ", \"births\": " << m.births << ", \"deaths\": " << m.deaths << ", \"bounds\": ";
+            if (empty) {
+                file << "null";
+            } else {
+                file << "[" << m.minX << ", " << m.minY << ", " << m.maxX << ", " << m.maxY << "]";
+            }
+            file << ", \"active\": " << m.active << ", \"generations_per_second\": " << rate << "}\n";
+        } else {
+            file << m.generation << "," << m.population << "," << m.births << "," << m.deaths << ",";
+            if (empty) {
+                file << ",,,";
+            } else {
+                file << m.minX << "," << m.minY << "," << m.maxX << "," << m.maxY;
+            }
+            file << "," << m.active << "," << rate << "\n";
+        }
+        lines++;
+        lastGeneration = m.generation;
+        lastTime = now;
+        if (now - lastFlush >= std::chrono::milliseconds(50)) {
+            file.flush();
+            lastFlush = now;
+        }
+        if (!file.good()) {
+            std::cerr << "Error: Could not write file " << path << std::endl;
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    // Flush the lines of a finished run
+    void endRun() {
+        if (file.is_open()) file.flush();
+    }
+
+    void close() {
+        if (file.is_open()) file.close();
+    }
+
+    void printStatus() const {
+        if (!file.is_open()) {
+            std::cout << "Metrics stream is off" << std::endl;
+            return;
+        }
+        std::cout << "Writing metrics every " << interval << " generations to " << path << " as "
+                  << (json ? "JSON" : "CSV") << " (" << lines << " lines so far)" << std::endl;
+    }
+};
+
+// CheckpointWriter class - writes world snapshots on a background thread.
+// Two snapshots alternate: the simulation fills the spare one (by exchanging
+// buffers with the world) while the writer thread streams the other to disk.
+// A checkpoint that comes due while a write is still in flight is taken as
+// soon as the writer is free again.
+class CheckpointWriter {
+private:
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    GameOfLife::Snapshot snapshots[2];
+    GameOfLife::Snapshot* spare;    // Owned by the simulation while idle
+    GameOfLife::Snapshot* inFlight; // Owned by the writer thread while busy
+    std::string path;
+    bool busy;
+    bool stopping;
+    bool delaying;
+    uint64_t written;
+    uint64_t delayed;
+    uint64_t failed;
+    uint64_t lastGeneration;
+    double lastWriteMs;
+
+    void writerLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [this] { return busy || stopping; });
+            if (!busy) return;
+            std::string target = path;
+            lock.unlock();
+
+            // Write to a temporary file first so a crash never leaves a torn checkpoint
+            auto start = std::chrono::high_resolution_clock::now();
+            bool ok = GameOfLife::writeCheckpoint(*inFlight, target + ".tmp") &&
+                      std::rename((target + ".tmp").c_str(), target.c_str()) == 0;
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+            lock.lock();
+            if (ok) {
+                written++;
+                lastGeneration = inFlight->generation;
+                lastWriteMs = elapsed.count();
+            } else {
+                failed++;
+            }
+            busy = false;
+            wake.notify_all();
+        }
+    }
+
+public:
+    CheckpointWriter()
+        : spare(&snapshots[0]), inFlight(&snapshots[1]), busy(false), stopping(false), delaying(false),
+          written(0), delayed(0), failed(0), lastGeneration(0), lastWriteMs(0) {
+        thread = std::thread(&CheckpointWriter::writerLoop, this);
+    }
+
+    ~CheckpointWriter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        thread.join(); // Finishes a write in flight first
+    }
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    // Spare snapshot to fill, or nullptr while the previous checkpoint is
+    // still being written (the caller retries next generation; each
+    // checkpoint delayed this way is counted once)
+    GameOfLife::Snapshot* acquire() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (busy) {
+            if (!delaying) delayed++;
+            delaying = true;
+            return nullptr;
+        }
+        return spare;
+    }
+
+    // Hand the filled spare snapshot to the writer thread
+    void submit(const std::string& target) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::swap(spare, inFlight);
+            path = target;
+            busy = true;
+            delaying = false;
+        }
+        wake.notify_all();
+    }
+
+    // Block until no write is in flight
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [this] { return !busy; });
+    }
+
+    // Print write counts and the last write time
+    void printStatus() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::cout << "Checkpoints written: " << written << ", delayed (writer busy): " << delayed
+                  << ", failed: " << failed << std::endl;
+        if (written > 0) {
+            std::cout << "Last checkpoint: generation " << lastGeneration << " written in "
+                      << lastWriteMs << " ms" << std::endl;
+        }
+    }
+};
+
+// SnapshotStore - recent generations published for reader threads. The run
+// loop publishes a generation by swapping a history buffer out of the world
+// (as for checkpoints), so publishing never copies the grid. Readers pin the
+// newest snapshot and can query it for as long as they like while the
+// simulation keeps running: each reader announces the epoch it started
+// reading in, and a retired snapshot buffer is only reused once every reader
+// has announced a later epoch. A publish that finds every spare buffer still
+// pinned is skipped (and counted) instead of waiting for the readers.
+class SnapshotStore {
+public:
+    static constexpr int maxReaders = 16;
+
+private:
+    static constexpr int slotCount = 4;
+    static constexpr uint64_t idle = UINT64_MAX; // Pin of a reader that holds nothing
+
+    // Touched only by the publishing thread (apart from the snapshot a
+    // reader has pinned, which is not modified until it is released)
+    GameOfLife::Snapshot slots[slotCount];
+    uint64_t retiredAt[slotCount]; // Epoch at which a slot stopped being the newest, 0 while it is
+    bool used[slotCount];
+    uint64_t skipped;
+    uint64_t published;
+
+    std::atomic<int> newest;                // Slot of the newest snapshot, -1 before the first
+    std::atomic<uint64_t> epoch;            // Advanced by every publish
+    std::atomic<uint64_t> pinned[maxReaders];
+    std::atomic<bool> claimed[maxReaders];
+
+    // A slot that no reader can still be using, or -1
+    int freeSlot() const {
+        int current = newest.load();
+        for (int s = 0; s < slotCount; s++) {
+            if (s == current) continue;
+            if (!used[s]) return s;
+            bool released = true;
+            for (int r = 0; r < maxReaders && released; r++) {
+                released = pinned[r].load() >= retiredAt[s];
+            }
+            if (released) return s;
+        }
+        return -1;
+    }
+
+public:
+    SnapshotStore() : skipped(0), published(0), newest(-1), epoch(1) {
+        for (int s = 0; s < slotCount; s++) {
+            retiredAt[s] = 0;
+            used[s] = false;
+        }
+        for (int r = 0; r < maxReaders; r++) {
+            pinned[r].store(idle);
+            claimed[r].store(false);
+        }
+    }
+
+    SnapshotStore(const SnapshotStore&) = delete;
+    SnapshotStore& operator=(const SnapshotStore&) = delete;
+
+    // Publish a generation of the world: the state before its last step
+    // ('steps' generations ago, swapped out of its history), or with steps 0
+    // a copy of the current generation. Returns false if nothing was
+    // published because every spare buffer is pinned or the generation is
+    // no longer stored; the caller retries later.
+    bool publish(GameOfLife& world, uint64_t steps) {
+        int slot = freeSlot();
+        if (slot < 0) {
+            skipped++;
+            return false;
+        }
+        GameOfLife::Snapshot& snapshot = slots[slot];
+        world.prepareSnapshot(snapshot);
+        if (steps == 0) {
+            world.copyCheckpoint(snapshot);
+        } else if (!world.exchangeCheckpoint(snapshot, steps)) {
+            return false;
+        }
+        used[slot] = true;
+        retiredAt[slot] = 0;
+        uint64_t next = epoch.load() + 1;
+        int previous = newest.load();
+        if (previous >= 0) retiredAt[previous] = next;
+        newest.store(slot);
+        epoch.store(next); // Readers that announce this epoch can only see the new slot
+        published++;
+        return true;
+    }
+
+    // Claim a reader id for pin()/unpin(), or -1 if all are taken
+    int addReader() {
+        for (int r = 0; r < maxReaders; r++) {
+            bool expected = false;
+            if (claimed[r].compare_exchange_strong(expected, true)) return r;
+        }
+        return -1;
+    }
+
+    void removeReader(int reader) {
+        pinned[reader].store(idle);
+        claimed[reader].store(false);
+    }
+
+    // Pin the newest snapshot for reading (nullptr if none was published
+    // yet); it stays valid and unchanged until unpin()
+    const GameOfLife::Snapshot* pin(int reader) {
+        while (true) {
+            uint64_t seen = epoch.load();
+            pinned[reader].store(seen);
+            int slot = newest.load();
+            // A publish in between may have retired 'slot' after our announcement was checked
+            if (epoch.load() != seen) continue;
+            if (slot < 0) {
+                pinned[reader].store(idle);
+                return nullptr;
+            }
+            return &slots[slot];
+        }
+    }
+
+    void unpin(int reader) {
+        pinned[reader].store(idle);
+    }
+
+    // Print publish counts and the newest generation (publishing thread only)
+    void printStatus() const {
+        int slot = newest.load();
+        std::cout << "Snapshots published: " << published << ", skipped (buffers pinned): " << skipped << std::endl;
+        if (slot >= 0) {
+            std::cout << "Newest snapshot: generation " << slots[slot].generation << std::endl;
+        }
+    }
+};
+
+// SnapshotWatch - background reader of a SnapshotStore: polls for new
+// snapshots and appends a region of each one to a file as the generation
+// (one 64-bit word) followed by the packed region rows (see getRegion)
+class SnapshotWatch {
+private:
+    SnapshotStore& store;
+    std::thread thread;
+    std::atomic<bool> stopping;
+    std::atomic<uint64_t> frames;
+    int reader;
+    std::FILE* file;
+    int64_t x, y;
+    int w, h;
+    static constexpr int pollMicroseconds = 1000;
+
+    void watchLoop() {
+        std::vector<uint64_t> words(static_cast<size_t>(h) * ((w + 63) / 64));
+        bool first = true;
+        uint64_t lastGeneration = 0;
+        while (!stopping.load()) {
+            const GameOfLife::Snapshot* snapshot = store.pin(reader);
+            if (snapshot && (first || snapshot->generation != lastGeneration)) {
+                lastGeneration = snapshot->generation;
+                first = false;
+                snapshot->getRegion(x, y, w, h, words.data());
+                store.unpin(reader);
+                std::fwrite(&lastGeneration, sizeof(lastGeneration), 1, file);
+                std::fwrite(words.data(), sizeof(uint64_t), words.size(), file);
+                frames++;
+                continue;
+            }
+            store.unpin(reader);
+            std::this_thread::sleep_for(std::chrono::microseconds(pollMicroseconds));
+        }
+    }
+
+public:
+    explicit SnapshotWatch(SnapshotStore& snapshots)
+        : store(snapshots), stopping(false), frames(0), reader(-1), file(nullptr), x(0), y(0), w(0), h(0) {}
+
+    ~SnapshotWatch() {
+        stop();
+    }
+
+    SnapshotWatch(const SnapshotWatch&) = delete;
+    SnapshotWatch& operator=(const SnapshotWatch&) = delete;
+
+    bool isActive() const {
+        return file != nullptr;
+    }
+
+    uint64_t getFrames() const {
+        return frames.load();
+    }
+
+    // Start appending the w x h region at (x, y) of every new snapshot to path
+    bool start(const std::string& path, int64_t regionX, int64_t regionY, int regionW, int regionH) {
+        stop();
+        reader = store.addReader();
+        if (reader < 0) {
+            std::cerr << "Error: No snapshot reader slot is free" << std::endl;
+            return false;
+        }
+        file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            std::cerr << "Error: Could not open file " << path << " for writing" << std::endl;
+            store.removeReader(reader);
+            return false;
+        }
+        x = regionX;
+        y = regionY;
+        w = regionW;
+        h = regionH;
+        frames.store(0);
+        stopping.store(false);
+        thread = std::thread(&SnapshotWatch::watchLoop, this);
+        return true;
+    }
+
+    void stop() {
+        if (!file) return;
+        stopping.store(true);
+        thread.join();
+        std::fclose(file);
+        file = nullptr;
+        store.removeReader(reader);
+        reader = -1;
+    }
+};
+
+// BatchOutput - stream buffer for non-interactive runs. std::endl asks for a
+// flush after every line; this buffer only passes a flush on when the last
+// one is at least flushInterval old (or when it fills up), so thousands of
+// command replies cost a few writes. With 'discard' set, output is dropped.
+class BatchOutput : public std::streambuf {
+private:
+    std::streambuf* target;        // Buffer the output finally goes to
+    std::vector<char> buffer;
+    bool discard;
+    std::chrono::steady_clock::time_point lastFlush;
+    static constexpr int flushIntervalMs = 50;
+
+    bool drain() {
+        std::ptrdiff_t size = pptr() - pbase();
+        bool ok = discard || size == 0 || target->sputn(pbase(), size) == size;
+        setp(buffer.data(), buffer.data() + buffer.size());
+        return ok;
+    }
+
+protected:
+    int overflow(int c) override {
+        if (!drain()) return traits_type::eof();
+        if (c != traits_type::eof()) {
+            *pptr() = static_cast<char>(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    int sync() override {
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastFlush < std::chrono::milliseconds(flushIntervalMs)) return 0;
+        lastFlush = now;
+        return (drain() && target->pubsync() == 0) ? 0 : -1;
+    }
+
+public:
+    explicit BatchOutput(std::streambuf* out)
+        : target(out), buffer(1 << 16), discard(false), lastFlush(std::chrono::steady_clock::now()) {
+        setp(buffer.data(), buffer.data() + buffer.size());
+    }
+
+    ~BatchOutput() override {
+        flush();
+    }
+
+    // Drop (or stop dropping) everything written from now on
+    void setDiscard(bool on) {
+        drain();
+        discard = on;
+    }
+
+    // Write out everything buffered so far
+    void flush() {
+        drain();
+        target->pubsync();
+        lastFlush = std::chrono::steady_clock::now();
+    }
+};
+
+// CommandLine class - handles user interaction
+class CommandLine {
+private:
+    GameOfLife* world;
+    HashLife hashLife;
+    Ensemble ensemble;            // Worlds evolved together by the 'ensemble' commands
+    bool printEnabled;
+    int delayTime;
+    bool stabilityCheckEnabled;
+    CheckpointWriter checkpointWriter;
+    std::string checkpointPath;   // Empty while checkpointing is off
+    uint64_t checkpointInterval;  // Generations between checkpoints
+    uint64_t nextCheckpoint;      // Generation at which the next checkpoint is due
+    RunRecorder recorder;
+    MetricsStream metricsStream;
+    SnapshotStore snapshots;      // Generations published for reader threads
+    SnapshotWatch snapshotWatch;  // Reader thread started by 'snapshot watch'
+    uint64_t snapshotInterval;    // Generations between snapshots, 0 while publishing is off
+    uint64_t nextSnapshot;        // Generation at which the next snapshot is due
+    static constexpr int64_t maxRegionCells = int64_t(1) << 32; // Largest region buffer (512 MB)
+    RunReplay replay;
+    TerminalRenderer renderer;
+    LifeRule rule;                // Rule for new, loaded and replayed worlds
+    std::string unknownCommand;   // Set when processCommand did not know a command
+    bool commandFailed;           // Set when the last command reported an error
+#ifdef GOL_PROFILING
+    std::string profilePath;      // JSON profile written after each run, empty for none
+#endif
+
+    // Give a new world the selected rule
+    void applyRule() {
+        if (!world->setRule(rule)) {
+            LifeRule binary = rule;
+            binary.states = 2;
+            world->setRule(binary);
+        }
+        reportRuleFallback();
+    }
+
+    // Tell the user if the world could not take the selected rule
+    void reportRuleFallback() {
+        if (world->getRule() != rule) {
+            std::cout << "Note: " << rule.toString() << " needs dense storage; this "
+                      << GameOfLife::storageName(world->getStorage()) << " world uses "
+                      << world->getRule().toString() << std::endl;
+        }
+    }
+
+    // Called after each step of a run; 'steps' generations were just advanced.
+    // The checkpoint is the state before the step, taken from the world's
+    // history by a buffer swap so the simulation does not wait for a copy.
+    void checkpointStep(uint64_t steps) {
+        if (checkpointPath.empty() || world->getGeneration() < nextCheckpoint + steps) return;
+        GOL_PROFILE_SCOPE(Checkpoint);
+        GameOfLife::Snapshot* snapshot = checkpointWriter.acquire();
+        if (!snapshot) return;
+        world->prepareSnapshot(*snapshot);
+        if (world->exchangeCheckpoint(*snapshot, steps)) {
+            checkpointWriter.submit(checkpointPath);
+            nextCheckpoint = world->getGeneration() - steps + checkpointInterval;
+        }
+    }
+
+    // Called after each step of a run, after checkpointStep (which takes the
+    // same history buffer first when both are due): publish the state before
+    // the step for reader threads
+    void snapshotStep(uint64_t steps) {
+        if (snapshotInterval == 0 || world->getGeneration() < nextSnapshot + steps) return;
+        if (snapshots.publish(*world, steps)) {
+            nextSnapshot = world->getGeneration() - steps + snapshotInterval;
+        }
+    }
+
+    // Clip a region to a bounded world (sparse worlds have no bounds).
+    // Reports and returns false if nothing of it is inside.
+    bool clipRegion(GameOfLife::Storage storage, int width, int height, int64_t& x, int64_t& y, int& w, int& h) {
+        if (storage == GameOfLife::Storage::Sparse) return true;
+        int64_t x0 = std::max<int64_t>(x, 0), y0 = std::max<int64_t>(y, 0);
+        int64_t x1 = std::min<int64_t>(x + w, width), y1 = std::min<int64_t>(y + h, height);
+        if (x0 >= x1 || y0 >= y1) {
+            std::cout << "The region is outside the " << width << "x" << height << " world" << std::endl;
+            return false;
+        }
+        x = x0;
+        y = y0;
+        w = static_cast<int>(x1 - x0);
+        h = static_cast<int>(y1 - y0);
+        return true;
+    }
+
+    // Check that the packed rows of a w x h region stay below maxRegionCells
+    // before they are allocated; reports and returns false otherwise
+    bool regionFits(int w, int h) {
+        if (static_cast<int64_t>(w) * h <= maxRegionCells) return true;
+        std::cout << "A " << w << "x" << h << " region is larger than the limit of " << maxRegionCells
+                  << " cells; query it in parts" << std::endl;
+        return false;
+    }
+
+    // Print a region read with getRegion(), or write its packed rows to a file
+    bool writeRegion(const std::vector<uint64_t>& words, int w, int h, const std::string& filename) {
+        if (!filename.empty()) {
+            std::ofstream out(filename, std::ios::binary);
+            if (!out.write(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(uint64_t))) {
+                std::cerr << "Error: Could not write file " << filename << std::endl;
+                return false;
+            }
+            return true;
+        }
+        int rowWords = (w + 63) / 64;
+        std::string line;
+        for (int r = 0; r < h; r++) {
+            line.clear();
+            for (int c = 0; c < w; c++) {
+                line += ((words[static_cast<size_t>(r) * rowWords + c / 64] >> (c % 64)) & 1) ? "■ " : "□ ";
+            }
+            std::cout << line << "\n";
+        }
+        return true;
+    }
+
+    // Called after each step of a run: stream the metrics of a measured generation
+    void metricsStep() {
+        if (metricsStream.isOpen() && world->hasMetrics()) {
+            metricsStream.write(world->getMetrics());
+        }
+    }
+
+public:
+    CommandLine()
+        : world(nullptr), printEnabled(true), delayTime(100), stabilityCheckEnabled(true),
+          checkpointInterval(0), nextCheckpoint(0), snapshotWatch(snapshots), snapshotInterval(0), nextSnapshot(0),
+          commandFailed(false) {}
+
+    ~CommandLine() {
+        if (world) delete world;
+    }
+
+    // Process a single command. Returns false to exit; an unknown command
+    // sets unknownCommand and any other error sets commandFailed.
+    bool processCommand(const std::string& input) {
+        std::istringstream iss(input);
+        std::string command;
+        iss >> command;
+        unknownCommand.clear();
+        commandFailed = false;
+
+        if (command == "exit" || command == "quit") {
+            return false;
+        } else if (command == "create") {
+            int width = 0, height = 0;
+            std::string storageArg;
+            iss >> width >> height >> storageArg;
+            GameOfLife::Storage storage = GameOfLife::Storage::Dense;
+            if (!storageArg.empty() && !GameOfLife::parseStorage(storageArg, storage)) {
+                commandFailed = true;
+                std::cout << "Unknown storage '" << storageArg << "'. Use 'dense', 'packed', 'tiled' or 'sparse'." << std::endl;
+            } else if (width > 0 && height > 0) {
+                if (world) delete world;
+                world = new GameOfLife(width, height, storage);
+                world->setCycleDetection(stabilityCheckEnabled);
+                std::cout << "Created a new world of size " << width << "x" << height
+                          << " (" << GameOfLife::storageName(storage) << " storage)" << std::endl;
+                applyRule();
+            } else {
+                commandFailed = true;
+                std::cout << "Invalid dimensions. Please provide positive values for width and height." << std::endl;
+            }
+        } else if (command == "load") {
+            std::string filename;
+            iss >> filename;
+            if (!filename.empty()) {
+                if (world) delete world;
+                auto start = std::chrono::high_resolution_clock::now();
+                world = new GameOfLife(filename, rule);
+                std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+                if (!world->isLoaded()) {
+                    delete world;
+                    world = nullptr;
+                    commandFailed = true;
+                    std::cout << "Could not load a world from " << filename << std::endl;
+                    return true;
+                }
+                world->setCycleDetection(stabilityCheckEnabled);
+                reportRuleFallback();
+                std::cout << "Loaded world from " << filename << " (" << world->getWidth() << "x" << world->getHeight()
+                          << ", " << GameOfLife::storageName(world->getStorage()) << " storage) in "
+                          << elapsed.count() << " ms" << std::endl;
+            } else {
+                commandFailed = true;
+                std::cout << "Please provide a filename." << std::endl;
+            }
+        } else if (command == "checkpoint") {
+            std::string mode;
+            iss >> mode;
+            if (mode == "every") {
+                uint64_t interval = 0;
+                std::string path;
+                iss >> interval >> path;
+                if (interval == 0 || path.empty()) {
+                    commandFailed = true;
+                    std::cout << "Usage: checkpoint every <n> <path>" << std::endl;
+                    return true;
+                }
+                checkpointPath = path;
+                checkpointInterval = interval;
+                nextCheckpoint = (world ? world->getGeneration() : 0) + interval;
+                std::cout << "Writing a checkpoint to " << path << " every " << interval
+                          << " generations during runs" << std::endl;
+            } else if (mode == "off") {
+                checkpointWriter.wait();
+                checkpointPath.clear();
+                std::cout << "Checkpointing disabled" << std::endl;
+            } else if (mode.empty()) {
+                if (checkpointPath.empty()) {
+                    std::cout << "Checkpointing is off" << std::endl;
+                } else {
+                    std::cout << "Checkpointing to " << checkpointPath << " every " << checkpointInterval
+                              << " generations (next at generation " << nextCheckpoint << ")" << std::endl;
+                }
+                checkpointWriter.printStatus();
+            } else {
+                commandFailed = true;
+                std::cout << "Unknown checkpoint mode '" << mode << "'. Use 'every <n> <path>' or 'off'." << std::endl;
+            }
+        } else if (command == "record") {
+            std::string filename, option;
+            uint64_t interval = 100;
+            iss >> filename >> option;
+            if (filename.empty()) {
+                recorder.printStatus();
+            } else if (filename == "off") {
+                recorder.close();
+                recorder.printStatus();
+            } else if (!world) {
+                commandFailed = true;
+                std::cout << "No world exists. Create or load a world first." << std::endl;
+            } else if (!option.empty() && (option != "keyframe" || !(iss >> interval) || interval == 0)) {
+                commandFailed = true;
+                std::cout << "Usage: record <file> [keyframe <k>]" << std::endl;
+            } else if (recorder.open(filename, *world, interval)) {
+                std::cout << "Recording generation " << world->getGeneration() << " onwards to " << filename
+                          << " (keyframe every " << interval << " frames)" << std::endl;
+            } else {
+                commandFailed = true;
+            }
+        } else if (command == "metrics") {
+            std::string mode;
+            iss >> mode;
+            if (mode == "every") {
+                uint64_t interval = 0;
+                std::string path, format;
+                iss >> interval >> path >> format;
+                if (format.empty()) {
+                    size_t dot = path.rfind('.');
+                    std::string extension = (dot == std::string::npos) ? "" : path.substr(dot);
+                    format = (extension == ".json" || extension == ".jsonl") ? "json" : "csv";
+                }
+                if (interval == 0 || path.empty() || (format != "csv" && format != "json")) {
+                    commandFailed = true;
+                    std::cout << "Usage: metrics every <n> <file> [csv|json]" << std::endl;
+                    return true;
+                }
+                if (metricsStream.open(path, interval, format == "json")) {
+                    metricsStream.printStatus();
+                } else {
+                    commandFailed = true;
+                }
+            } else if (mode == "off") {
+                metricsStream.close();
+                metricsStream.printStatus();
+            } else if (mode.empty()) {
+                metricsStream.printStatus();
+            } else {
+                commandFailed = true;
+                std::cout << "Unknown metrics mode '" << mode << "'. Use 'every <n> <file> [csv|json]' or 'off'." << std::endl;
+            }
+        } else if (command == "region") {
+            if (!world) {
+                commandFailed = true;
+                std::cout << "No world exists. Create or load a world first." << std::endl;
+                return true;
+            }
+            std::string first;
+            iss >> first;
+            bool setting = (first == "set");
+            std::istringstream coordinates(setting ? "" : first);
+            int64_t x = 0, y = 0;
+            int w = 0, h = 0;
+            std::string filename;
+            bool parsed = setting ? static_cast<bool>(iss >> x >> y >> w >> h)
+                                  : static_cast<bool>(coordinates >> x) && static_cast<bool>(iss >> y >> w >> h);
+            iss >> filename;
+            if (!parsed || w <= 0 || h <= 0 || (setting && filename.empty())) {
+                commandFailed = true;
+                std::cout << "Usage: region <x> <y> <w> <h> [file] or region set <x> <y> <w> <h> <file>" << std::endl;
+                return true;
+            }
+            // Reads of a bounded world are clipped to it; writes are clipped by setRegion
+            if ((!setting && !clipRegion(world->getStorage(), world->getWidth(), world->getHeight(), x, y, w, h)) ||
+                !regionFits(w, h)) {
+                commandFailed = true;
+                return true;
+            }
+            size_t regionBytes = static_cast<size_t>(h) * ((w + 63) / 64) * sizeof(uint64_t);
+            std::ifstream in;
+            if (setting) {
+                in.open(filename, std::ios::binary | std::ios::ate);
+                if (!in.is_open() || static_cast<size_t>(in.tellg()) < regionBytes) {
+                    commandFailed = true;
+                    std::cerr << "Error: " << filename << " does not hold " << regionBytes << " bytes of region rows"
+                              << std::endl;
+                    return true;
+                }
+                in.seekg(0);
+            }
+            std::vector<uint64_t> words(regionBytes / sizeof(uint64_t));
+            std::chrono::duration<double, std::milli> elapsed(0);
+            if (setting) {
+                if (!in.read(reinterpret_cast<char*>(words.data()), words.size() * sizeof(uint64_t))) {
+                    commandFailed = true;
+                    std::cerr << "Error: " << filename << " does not hold " << words.size() * sizeof(uint64_t)
+                              << " bytes of region rows" << std::endl;
+                    return true;
+                }
+                auto start = std::chrono::high_resolution_clock::now();
+                world->setRegion(x, y, w, h, words.data());
+                elapsed = std::chrono::high_resolution_clock::now() - start;
+                std::cout << "Wrote " << w << "x" << h << " region at (" << x << "," << y << ")";
+            } else {
+                auto start = std::chrono::high_resolution_clock::now();
+                world->getRegion(x, y, w, h, words.data());
+                elapsed = std::chrono::high_resolution_clock::now() - start;
+                if (!writeRegion(words, w, h, filename)) {
+                    commandFailed = true;
+                    return true;
+                }
+                std::cout << "Read " << w << "x" << h << " region at (" << x << "," << y << ")";
+            }
+            std::cout << " in " << elapsed.count() << " ms ("
+                      << static_cast<double>(w) * h / std::max(elapsed.count(), 1e-6) / 1e3 << " Mcells/s)" << std::endl;
+        } else if (command == "snapshot") {
+            std::string mode;
+            iss >> mode;
+            if (mode == "every") {
+                uint64_t interval = 0;
+                iss >> interval;
+                if (interval == 0) {
+                    commandFailed = true;
+                    std::cout << "Usage: snapshot every <n>" << std::endl;
+                    return true;
+                }
+                snapshotInterval = interval;
+                nextSnapshot = (world ? world->getGeneration() : 0) + interval;
+                std::cout << "Publishing a snapshot every " << interval << " generations during runs" << std::endl;
+            } else if (mode == "off") {
+                snapshotInterval = 0;
+                std::cout << "Snapshot publishing disabled" << std::endl;
+            } else if (mode == "take") {
+                if (!world) {
+                    commandFailed = true;
+                    std::cout << "No world exists. Create or load a world first." << std::endl;
+                } else if (snapshots.publish(*world, 0)) {
+                    std::cout << "Published generation " << world->getGeneration() << std::endl;
+                } else {
+                    commandFailed = true;
+                    std::cout << "Every snapshot buffer is pinned by a reader; try again later" << std::endl;
+                }
+            } else if (mode == "region") {
+                int64_t x = 0, y = 0;
+                int w = 0, h = 0;
+                std::string filename;
+                if (!(iss >> x >> y >> w >> h) || w <= 0 || h <= 0) {
+                    commandFailed = true;
+                    std::cout << "Usage: snapshot region <x> <y> <w> <h> [file]" << std::endl;
+                    return true;
+                }
+                iss >> filename;
+                int reader = snapshots.addReader();
+                if (reader < 0) {
+                    commandFailed = true;
+                    std::cout << "No snapshot reader slot is free" << std::endl;
+                    return true;
+                }
+                const GameOfLife::Snapshot* snapshot = snapshots.pin(reader);
+                bool fits = snapshot && clipRegion(snapshot->storage, snapshot->width, snapshot->height, x, y, w, h) &&
+                            regionFits(w, h);
+                std::vector<uint64_t> words;
+                uint64_t gen = snapshot ? snapshot->generation : 0;
+                if (fits) {
+                    words.resize(static_cast<size_t>(h) * ((w + 63) / 64));
+                    snapshot->getRegion(x, y, w, h, words.data());
+                }
+                snapshots.removeReader(reader);
+                if (!snapshot) {
+                    commandFailed = true;
+                    std::cout << "No snapshot published yet. Use 'snapshot every <n>' or 'snapshot take'." << std::endl;
+                } else if (!fits) {
+                    commandFailed = true;
+                } else if (writeRegion(words, w, h, filename)) {
+                    std::cout << "Read " << w << "x" << h << " region of generation " << gen << std::endl;
+                } else {
+                    commandFailed = true;
+                }
+            } else if (mode == "watch") {
+                std::string first;
+                iss >> first;
+                if (first == "off") {
+                    snapshotWatch.stop();
+                    std::cout << "Snapshot watch stopped after " << snapshotWatch.getFrames() << " frames" << std::endl;
+                    return true;
+                }
+                std::istringstream coordinates(first);
+                int64_t x = 0, y = 0;
+                int w = 0, h = 0;
+                std::string filename;
+                if (!(coordinates >> x) || !(iss >> y >> w >> h >> filename) || w <= 0 || h <= 0) {
+                    commandFailed = true;
+                    std::cout << "Usage: snapshot watch <x> <y> <w> <h> <file> or snapshot watch off" << std::endl;
+                    return true;
+                }
+                if (!regionFits(w, h)) {
+                    commandFailed = true;
+                } else if (snapshotWatch.start(filename, x, y, w, h)) {
+                    std::cout << "Appending the " << w << "x" << h << " region at (" << x << "," << y
+                              << ") of every new snapshot to " << filename << std::endl;
+                } else {
+                    commandFailed = true;
+                }
+            } else if (mode.empty()) {
+                if (snapshotInterval == 0) {
+                    std::cout << "Snapshot publishing is off" << std::endl;
+                } else {
+                    std::cout << "Publishing a snapshot every " << snapshotInterval << " generations (next at generation "
+                              << nextSnapshot << ")" << std::endl;
+                }
+                snapshots.printStatus();
+                if (snapshotWatch.isActive()) {
+                    std::cout << "Snapshot watch: " << snapshotWatch.getFrames() << " frames written" << std::endl;
+                }
+            } else {
+                commandFailed = true;
+                std::cout << "Unknown snapshot mode '" << mode
+                          << "'. Use 'every <n>', 'off', 'take', 'region ...' or 'watch ...'." << std::endl;
+            }
+        } else if (command == "replay") {
+            std::string filename;
+            iss >> filename;
+            if (filename.empty()) {
+                commandFailed = true;
+                std::cout << "Please provide a recording file." << std::endl;
+                return true;
+            }
+            if (!replay.open(filename)) {
+                commandFailed = true;
+                return true;
+            }
+            const std::vector<RunReplay::Frame>& frames = replay.getFrames();
+            uint64_t from = frames.front().generation, to = frames.back().generation;
+            uint64_t value = 0;
+            if (iss >> value) {
+                from = value;
+                if (iss >> value) to = value;
+            }
+            size_t first = replay.findFrame(from), last = replay.findFrame(to);
+            if (first == frames.size() || last == frames.size() || first > last) {
+                commandFailed = true;
+                std::cout << "Generations " << from << " to " << to << " are not in the recording ("
+                          << frames.front().generation << " to " << frames.back().generation << ")" << std::endl;
+                return true;
+            }
+            if (world) delete world;
+            world = new GameOfLife(replay.getWidth(), replay.getHeight(), replay.getStorage());
+            world->setCycleDetection(false);
+            applyRule();
 
-        if (command == "exit" || command == "quit") {
-            return false;
-        } else if (command == "create") {
-            int width, height;
-            iss >> width >> height;
-            if (width > 0 && height > 0) {
+            auto start = std::chrono::high_resolution_clock::now();
+            if (printEnabled) {
+                renderer.begin();
+            }
+            for (size_t i = first; i <= last; i++) {
+                if (!replay.seek(i)) {
+                    commandFailed = true;
+                    std::cerr << "Error: Corrupt frame for generation " << frames[i].generation << std::endl;
+                    break;
+                }
+                world->restoreGeneration(replay.rows(), frames[i].generation);
+                if (printEnabled) {
+                    showGeneration(static_cast<int>(i - first + 1), static_cast<int>(last - first + 1));
+                }
+            }
+            if (printEnabled) {
+                renderer.end();
+            }
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+            world->setCycleDetection(stabilityCheckEnabled);
+            std::cout << "Replayed generations " << from << " to " << to << " (" << last - first + 1 << " frames) in "
+                      << elapsed.count() << " ms; 'seek <gen>' jumps within " << filename << std::endl;
+        } else if (command == "seek") {
+            uint64_t gen = 0;
+            if (!(iss >> gen)) {
+                commandFailed = true;
+                std::cout << "Please provide a generation." << std::endl;
+                return true;
+            }
+            if (!replay.isOpen()) {
+                commandFailed = true;
+                std::cout << "No recording is open. Use 'replay <file>' first." << std::endl;
+                return true;
+            }
+            size_t frame = replay.findFrame(gen);
+            if (frame == replay.getFrames().size()) {
+                commandFailed = true;
+                std::cout << "Generation " << gen << " is not in the recording." << std::endl;
+                return true;
+            }
+            auto start = std::chrono::high_resolution_clock::now();
+            if (!replay.seek(frame)) {
+                commandFailed = true;
+                std::cerr << "Error: Corrupt frame for generation " << gen << std::endl;
+                return true;
+            }
+            if (!world || world->getWidth() != replay.getWidth() || world->getHeight() != replay.getHeight() ||
+                world->getStorage() != replay.getStorage()) {
                 if (world) delete world;
-                world = new GameOfLife(width, height);
-                std::cout << "Created a new world of size " << width << "x" << height << std::endl;
-            } else {
-                std::cout << "Invalid dimensions. Please provide positive values for width and height." << std::endl;
+                world = new GameOfLife(replay.getWidth(), replay.getHeight(), replay.getStorage());
+                applyRule();
             }
-        } else if (command == "load") {
+            world->restoreGeneration(replay.rows(), gen);
+            world->setCycleDetection(stabilityCheckEnabled);
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+            std::cout << "Reconstructed generation " << gen << " in " << elapsed.count() << " ms" << std::endl;
+        } else if (command == "resume") {
             std::string filename;
             iss >> filename;
-            if (!filename.empty()) {
-                if (world) delete world;
-                world = new GameOfLife(filename);
-                std::cout << "Loaded world from " << filename << std::endl;
-            } else {
-                std::cout << "Please provide a filename." << std::endl;
+            if (filename.empty()) {
+                commandFailed = true;
+                std::cout << "Please provide a checkpoint file." << std::endl;
+                return true;
+            }
+            checkpointWriter.wait(); // The file may still be being written
+            if (world) delete world;
+            auto start = std::chrono::high_resolution_clock::now();
+            world = new GameOfLife(filename, rule);
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+            if (!world->isLoaded()) {
+                delete world;
+                world = nullptr;
+                commandFailed = true;
+                std::cout << "Could not resume from " << filename << std::endl;
+                return true;
             }
+            reportRuleFallback();
+            // Keep the restored cycle history unless the stability check is off
+            if (!stabilityCheckEnabled) world->setCycleDetection(false);
+            if (!checkpointPath.empty()) nextCheckpoint = world->getGeneration() + checkpointInterval;
+            std::cout << "Resumed " << world->getWidth() << "x" << world->getHeight() << " "
+                      << GameOfLife::storageName(world->getStorage()) << " world at generation "
+                      << world->getGeneration() << " (" << world->getCycleHistorySize()
+                      << " states of cycle history) in " << elapsed.count() << " ms" << std::endl;
         } else if (command == "save") {
             if (!world) {
+                commandFailed = true;
                 std::cout << "No world exists. Create or load a world first." << std::endl;
                 return true;
             }
             
-            std::string filename;
-            iss >> filename;
-            if (!filename.empty()) {
-                if (world->save(filename)) {
-                    std::cout << "Saved world to " << filename << std::endl;
+            std::string filename, format;
+            iss >> filename >> format;
+            if (!format.empty() && format != "text" && format != "binary" && format != "binary-rle") {
+                commandFailed = true;
+                std::cout << "Unknown format '" << format << "'. Use 'text', 'binary' or 'binary-rle'." << std::endl;
+            } else if (!filename.empty()) {
+                auto start = std::chrono::high_resolution_clock::now();
+                bool saved = (format.empty() || format == "text") ? world->save(filename)
+                                                                  : world->saveBinary(filename, format == "binary-rle");
+                std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+                if (saved) {
+                    std::cout << "Saved world to " << filename << " in " << elapsed.count() << " ms" << std::endl;
+                } else {
+                    commandFailed = true;
                 }
             } else {
+                commandFailed = true;
+                std::cout << "Please provide a filename." << std::endl;
+            }
+        } else if (command == "import") {
+            if (!world) {
+                commandFailed = true;
+                std::cout << "No world exists. Create or load a world first." << std::endl;
+                return true;
+            }
+
+            std::string filename;
+            long long x = 0, y = 0;
+            iss >> filename >> x >> y;
+            if (filename.empty()) {
+                commandFailed = true;
+                std::cout << "Please provide a filename." << std::endl;
+                return true;
+            }
+            PatternFile::Stats stats;
+            auto start = std::chrono::high_resolution_clock::now();
+            bool macrocell = PatternFile::isMacrocell(filename);
+            bool imported = macrocell ? PatternFile::importMacrocell(*world, filename, x, y, stats)
+                                      : PatternFile::importRLE(*world, filename, x, y, stats);
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+            if (imported) {
+                std::cout << "Imported " << (macrocell ? "macrocell" : "RLE") << " pattern " << filename << " ("
+                          << stats.width << "x" << stats.height << ", " << stats.cells << " live cells) at ("
+                          << x << ", " << y << ") in " << elapsed.count() << " ms, "
+                          << stats.bytes / 1048576.0 / std::max(elapsed.count() / 1000.0, 1e-9) << " MB/s" << std::endl;
+            } else {
+                commandFailed = true;
+            }
+        } else if (command == "export") {
+            if (!world) {
+                commandFailed = true;
+                std::cout << "No world exists. Create or load a world first." << std::endl;
+                return true;
+            }
+
+            std::string filename, format;
+            iss >> filename >> format;
+            if (filename.empty()) {
+                commandFailed = true;
                 std::cout << "Please provide a filename." << std::endl;
+                return true;
+            }
+            if (format.empty()) {
+                bool mcExtension = filename.size() > 3 && filename.compare(filename.size() - 3, 3, ".mc") == 0;
+                format = mcExtension ? "mc" : "rle";
+            }
+            if (format != "rle" && format != "mc") {
+                commandFailed = true;
+                std::cout << "Unknown format '" << format << "'. Use 'rle' or 'mc'." << std::endl;
+                return true;
+            }
+            PatternFile::Stats stats;
+            auto start = std::chrono::high_resolution_clock::now();
+            bool exported = (format == "mc") ? PatternFile::exportMacrocell(*world, filename, stats)
+                                             : PatternFile::exportRLE(*world, filename, stats);
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+            if (exported) {
+                std::cout << "Exported " << stats.cells << " live cells to " << filename << " (" << format << ", "
+                          << stats.bytes << " bytes) in " << elapsed.count() << " ms" << std::endl;
+            } else {
+                commandFailed = true;
             }
         } else if (command == "print") {
             int value;
             iss >> value;
             printEnabled = (value != 0);
             std::cout << "Printing is now " << (printEnabled ? "enabled" : "disabled") << std::endl;
+        } else if (command == "render") {
+            std::string name;
+            iss >> name;
+            TerminalRenderer::Glyphs glyphs;
+            if (name.empty()) {
+                std::cout << "Render glyphs: " << TerminalRenderer::glyphsName(renderer.getGlyphs()) << std::endl;
+            } else if (TerminalRenderer::parseGlyphs(name, glyphs)) {
+                renderer.setGlyphs(glyphs);
+                std::cout << "Rendering with " << name << " glyphs" << std::endl;
+            } else {
+                commandFailed = true;
+                std::cout << "Unknown glyphs '" << name << "'. Use 'classic', 'block', 'half' or 'braille'." << std::endl;
+            }
+        } else if (command == "view") {
+            std::string first;
+            iss >> first;
+            if (first == "fit") {
+                if (!world) {
+                    commandFailed = true;
+                    std::cout << "No world exists. Create or load a world first." << std::endl;
+                    return true;
+                }
+                renderer.fit(*world);
+            } else if (!first.empty()) {
+                std::istringstream origin(first);
+                long long x = 0, y = 0;
+                int zoom = 1;
+                if (!(origin >> x) || !(iss >> y)) {
+                    commandFailed = true;
+                    std::cout << "Usage: view <x> <y> [zoom] or view fit" << std::endl;
+                    return true;
+                }
+                if (!(iss >> zoom)) zoom = 1;
+                renderer.setView(x, y, zoom);
+            }
+            std::cout << "View origin (" << renderer.getViewX() << ", " << renderer.getViewY() << "), zoom "
+                      << renderer.getZoom() << " cells per dot" << std::endl;
+        } else if (command == "fps") {
+            int fps = 0;
+            if (iss >> fps) renderer.setMaxFps(fps);
+            std::cout << "Frame rate limit: ";
+            if (renderer.getMaxFps() > 0) std::cout << renderer.getMaxFps() << " frames/s" << std::endl;
+            else std::cout << "none" << std::endl;
         } else if (command == "delay") {
             iss >> delayTime;
             std::cout << "Delay set to " << delayTime << " ms" << std::endl;
@@ -390,74 +7292,375 @@ public:
             int value;
             iss >> value;
             stabilityCheckEnabled = (value != 0);
+            if (world) world->setCycleDetection(stabilityCheckEnabled);
             std::cout << "Stability check is now " << (stabilityCheckEnabled ? "enabled" : "disabled") << std::endl;
+        } else if (command == "period") {
+            if (!world) {
+                commandFailed = true;
+                std::cout << "No world exists. Create or load a world first." << std::endl;
+                return true;
+            }
+            
+            int period = 0;
+            iss >> period;
+            if (period > 0) {
+                world->setMaxCyclePeriod(period);
+                std::cout << "Stability check detects cycles up to period " << period << std::endl;
+            } else {
+                std::cout << "Stability check detects cycles up to period " << world->getMaxCyclePeriod() << std::endl;
+            }
         } else if (command == "run") {
             if (!world) {
+                commandFailed = true;
                 std::cout << "No world exists. Create or load a world first." << std::endl;
                 return true;
             }
             
-            int generations;
+            int generations = 0;
             iss >> generations;
             if (generations <= 0) {
+                commandFailed = true;
                 std::cout << "Please provide a positive number of generations." << std::endl;
                 return true;
             }
+            int block = 1;
+            if (!parseBlockOption(iss, block)) return true;
             
-            runSimulation(generations);
+            runSimulation(generations, block);
         } else if (command == "benchmark") {
             if (!world) {
+                commandFailed = true;
                 std::cout << "No world exists. Create or load a world first." << std::endl;
                 return true;
             }
             
-            int generations;
+            int generations = 0;
             iss >> generations;
             if (generations <= 0) {
+                commandFailed = true;
                 std::cout << "Please provide a positive number of generations." << std::endl;
                 return true;
             }
+            int block = 1;
+            if (!parseBlockOption(iss, block)) return true;
             
             std::cout << "Running benchmark with " << omp_get_max_threads() << " threads..." << std::endl;
-            double elapsed = world->benchmarkEvolution(generations);
+#ifdef GOL_PROFILING
+            Profiler::instance().begin();
+#endif
+            double elapsed = world->benchmarkEvolution(generations, block);
+#ifdef GOL_PROFILING
+            Profiler::instance().end();
+            if (!profilePath.empty() && Profiler::instance().writeJSON(profilePath)) {
+                std::cout << "Profile written to " << profilePath << std::endl;
+            }
+#endif
             std::cout << "Benchmark completed: " << generations << " generations in " 
                       << elapsed << " ms" << std::endl;
             std::cout << "Average time per generation: " << elapsed / generations << " ms" << std::endl;
+        } else if (command == "jump") {
+            if (!world) {
+                commandFailed = true;
+                std::cout << "No world exists. Create or load a world first." << std::endl;
+                return true;
+            }
+            
+            unsigned long long generations = 0;
+            iss >> generations;
+            if (generations == 0) {
+                commandFailed = true;
+                std::cout << "Please provide a positive number of generations." << std::endl;
+                return true;
+            }
+            
+            auto start = std::chrono::high_resolution_clock::now();
+            if (hashLife.jump(*world, generations)) {
+                std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+                std::cout << "Jumped " << generations << " generations in " << elapsed.count() << " ms (HashLife, "
+                          << hashLife.getNodeCount() << " nodes, "
+                          << hashLife.memoryUsage() / (1024 * 1024) << " MB)" << std::endl;
+            } else {
+                // HashLife needs a square power-of-two torus; evolve normally otherwise
+                std::cout << "HashLife needs a square world with a power-of-two side and a two-state rule; "
+                          << "evolving step by step..." << std::endl;
+                for (unsigned long long i = 0; i < generations; i++) {
+                    world->evolve();
+                }
+                std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+                std::cout << "Advanced " << generations << " generations in " << elapsed.count() << " ms" << std::endl;
+            }
+            if (recorder.isOpen()) recorder.append(*world);
+        } else if (command == "ensemble") {
+            std::string sub;
+            iss >> sub;
+            if (sub == "run") {
+                unsigned long long generations = 0;
+                iss >> generations;
+                if (ensemble.size() == 0 || generations == 0) {
+                    commandFailed = true;
+                    std::cout << "Usage: ensemble run <generations> (after 'ensemble <n> <width> <height>')" << std::endl;
+                    return true;
+                }
+                auto start = std::chrono::high_resolution_clock::now();
+                uint64_t steps = ensemble.run(generations);
+                std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+                double cells = static_cast<double>(steps) * ensemble.getWidth() * ensemble.getHeight();
+                std::cout << "Advanced " << ensemble.size() << " worlds by up to " << generations << " generations ("
+                          << steps << " world generations) in " << elapsed.count() * 1000 << " ms, "
+                          << cells / std::max(elapsed.count(), 1e-9) / 1e9 << " Gcells/s; "
+                          << ensemble.stableCount() << " stable" << std::endl;
+            } else if (sub == "stats") {
+                if (ensemble.size() == 0) {
+                    commandFailed = true;
+                    std::cout << "No ensemble exists. Create one with 'ensemble <n> <width> <height>'." << std::endl;
+                    return true;
+                }
+                uint64_t minGen = UINT64_MAX, maxGen = 0, population = 0;
+                std::vector<size_t> periodCounts(static_cast<size_t>(ensemble.getMaxCyclePeriod()) + 1, 0);
+                for (size_t i = 0; i < ensemble.size(); i++) {
+                    minGen = std::min(minGen, ensemble.getGeneration(i));
+                    maxGen = std::max(maxGen, ensemble.getGeneration(i));
+                    population += ensemble.getPopulation(i);
+                    periodCounts[ensemble.getCyclePeriod(i)]++;
+                }
+                std::cout << "Ensemble: " << ensemble.size() << " worlds of " << ensemble.getWidth() << "x"
+                          << ensemble.getHeight() << " (" << ensemble.getRule().toString() << ")" << std::endl;
+                std::cout << "Generations: " << minGen << " to " << maxGen << std::endl;
+                std::cout << "Population: " << population << std::endl;
+                std::cout << "Stable: " << ensemble.stableCount() << " (running: " << periodCounts[0] << ")" << std::endl;
+                for (size_t p = 1; p < periodCounts.size(); p++) {
+                    if (periodCounts[p] > 0) std::cout << "  period " << p << ": " << periodCounts[p] << std::endl;
+                }
+            } else if (sub == "pick") {
+                long long index = -1;
+                iss >> index;
+                if (index < 0 || static_cast<size_t>(index) >= ensemble.size()) {
+                    commandFailed = true;
+                    std::cout << "Please provide a world index below " << ensemble.size() << "." << std::endl;
+                    return true;
+                }
+                // The picked world becomes the current world, packed
+                if (world) delete world;
+                world = new GameOfLife(ensemble.getWidth(), ensemble.getHeight(), GameOfLife::Storage::Packed);
+                world->setCycleDetection(stabilityCheckEnabled);
+                world->setRule(ensemble.getRule());
+                std::vector<uint64_t> rows(static_cast<size_t>((ensemble.getWidth() + 63) / 64) * ensemble.getHeight());
+                ensemble.copyWorld(index, rows.data());
+                world->restoreGeneration(rows.data(), ensemble.getGeneration(index));
+                std::cout << "World " << index << " of the ensemble is now the current world (generation "
+                          << world->getGeneration() << ")" << std::endl;
+            } else {
+                // ensemble <n> <width> <height> [density [seed]]
+                long long count = 0;
+                int width = 0, height = 0;
+                double density = 0.35;
+                unsigned long long seed = 0;
+                std::istringstream countStream(sub);
+                countStream >> count;
+                iss >> width >> height;
+                if (count <= 0 || width <= 0 || height <= 0) {
+                    commandFailed = true;
+                    std::cout << "Usage: ensemble <n> <width> <height> [density [seed]]" << std::endl;
+                    return true;
+                }
+                iss >> density;
+                if (!(iss >> seed)) {
+                    std::random_device rd;
+                    seed = (static_cast<unsigned long long>(rd()) << 32) | rd();
+                }
+                if (!ensemble.reset(static_cast<size_t>(count), width, height, rule, stabilityCheckEnabled ? 64 : 0)) {
+                    commandFailed = true;
+                    std::cout << "Ensembles need a two-state rule; " << rule.toString() << " has dying states." << std::endl;
+                    return true;
+                }
+                ensemble.fillRandom(density, seed);
+                std::cout << "Created an ensemble of " << count << " worlds of " << width << "x" << height
+                          << " at density " << density << " (seeds " << seed << " to " << seed + count - 1 << ")"
+                          << std::endl;
+            }
+        } else if (command == "distributed") {
+#ifdef GOL_MPI
+            // Every rank runs the same command (mpirun -np <ranks> game_of_life --distributed ...)
+            std::string source;
+            iss >> source;
+            DistributedWorld::initialize();
+            DistributedWorld strip(rule, stabilityCheckEnabled ? 64 : 0);
+            bool master = strip.getRank() == 0;
+            if (rule.isGenerations()) {
+                commandFailed = true;
+                if (master) std::cout << "Distributed worlds need a two-state rule." << std::endl;
+                return true;
+            }
+            bool ready = false;
+            if (source == "fill") {
+                int width = 0, height = 0;
+                double density = 0;
+                unsigned long long seed = 0;
+                iss >> width >> height >> density >> seed;
+                ready = strip.fill(width, height, density, seed);
+            } else if (source == "load") {
+                std::string filename;
+                iss >> filename;
+                ready = strip.load(filename);
+            } else if (master) {
+                commandFailed = true;
+                std::cout << "Usage: distributed fill <width> <height> <density> <seed> <generations> [output]" << std::endl;
+                std::cout << "       distributed load <file> <generations> [output]" << std::endl;
+            }
+            unsigned long long generations = 0;
+            std::string output;
+            iss >> generations >> output;
+            if (!ready) {
+                commandFailed = true;
+                return true;
+            }
+            if (master) {
+                std::cout << "Distributed " << strip.getWidth() << "x" << strip.getHeight() << " world over "
+                          << strip.getRanks() << " ranks (" << strip.getHeight() / strip.getRanks()
+                          << "+ rows each)" << std::endl;
+            }
+
+            DistributedWorld::barrier();
+            auto start = std::chrono::high_resolution_clock::now();
+            uint64_t done = strip.run(generations);
+            DistributedWorld::barrier();
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+            uint64_t population = strip.population();
+            if (master) {
+                double cells = static_cast<double>(done) * strip.getWidth() * strip.getHeight();
+                std::cout << "Ran " << done << " generations in " << elapsed.count() << " ms ("
+                          << cells / std::max(elapsed.count(), 1e-9) / 1e6 << " Gcells/s); rank 0 waited "
+                          << strip.getHaloWaitMs() << " ms for halos and " << strip.getReduceMs()
+                          << " ms in reductions" << std::endl;
+                if (strip.getCyclePeriod() > 0) {
+                    std::cout << "World has reached a stable state (period " << strip.getCyclePeriod() << ") after "
+                              << strip.getGeneration() << " generations." << std::endl;
+                }
+                std::cout << "Generation: " << strip.getGeneration() << ", population: " << population << std::endl;
+            }
+            if (!output.empty()) {
+                if (!strip.save(output)) {
+                    commandFailed = true;
+                } else if (master) {
+                    std::cout << "World saved to " << output << " (binary)" << std::endl;
+                }
+            }
+#else
+            commandFailed = true;
+            std::cout << "This build has no distributed mode; configure with MPI available and -DGOL_MPI=ON." << std::endl;
+#endif
+        } else if (command == "hashmem") {
+            int megabytes = 0;
+            iss >> megabytes;
+            if (megabytes > 0) {
+                hashLife.setMemoryLimit(static_cast<size_t>(megabytes) * 1024 * 1024);
+                std::cout << "HashLife node cache limited to " << megabytes << " MB" << std::endl;
+            } else {
+                std::cout << "HashLife node cache: " << hashLife.memoryUsage() / (1024 * 1024) << " MB used, limit "
+                          << hashLife.getMemoryLimit() / (1024 * 1024) << " MB, "
+                          << hashLife.getCollections() << " collections" << std::endl;
+            }
         } else if (command == "threads") {
-            int numThreads;
-            iss >> numThreads;
+            int numThreads = 0;
+            std::string mode;
+            iss >> numThreads >> mode;
             if (numThreads > 0) {
                 omp_set_num_threads(numThreads);
                 std::cout << "Set number of threads to " << numThreads << std::endl;
+                if (mode == "pin" || (mode.empty() && ThreadAffinity::isPinned())) {
+                    if (ThreadAffinity::pin()) {
+                        std::cout << "Threads pinned to CPUs" << std::endl;
+                    } else {
+                        commandFailed = true;
+                        std::cout << "Thread pinning is not supported on this system." << std::endl;
+                    }
+                } else if (mode == "nopin") {
+                    ThreadAffinity::unpin();
+                    std::cout << "Threads unpinned" << std::endl;
+                } else if (!mode.empty()) {
+                    commandFailed = true;
+                    std::cout << "Unknown mode '" << mode << "'. Use 'pin' or 'nopin'." << std::endl;
+                }
+                // Move each row band to the node of the thread that now owns it
+                if (world) world->placeMemory();
+            } else {
+                std::cout << "Current number of threads: " << omp_get_max_threads()
+                          << (ThreadAffinity::isPinned() ? " (pinned)" : "") << std::endl;
+            }
+        } else if (command == "rule") {
+            std::string spec;
+            iss >> spec;
+            if (spec.empty()) {
+                std::cout << "Current rule: " << (world ? world->getRule() : rule).toString() << std::endl;
+                return true;
+            }
+            LifeRule parsed;
+            if (!LifeRule::parse(spec, parsed)) {
+                commandFailed = true;
+                std::cout << "Invalid rule '" << spec << "'. Use B/S notation (e.g. B36/S23, B2/S/C3 for Generations)"
+                          << " or life, highlife, daynight, seeds, briansbrain, starwars; B0 rules are not supported."
+                          << std::endl;
+                return true;
+            }
+            if (world && parsed.isGenerations() && world->getStorage() != GameOfLife::Storage::Dense) {
+                commandFailed = true;
+                std::cout << "Generations rules need dense storage; this world is "
+                          << GameOfLife::storageName(world->getStorage()) << "." << std::endl;
+                return true;
+            }
+            rule = parsed;
+            if (world) world->setRule(rule);
+            std::cout << "Rule set to " << rule.toString() << std::endl;
+        } else if (command == "kernel") {
+            std::string name;
+            iss >> name;
+            if (name.empty()) {
+                std::cout << "Current kernel: " << KernelRegistry::active().name
+                          << " (available: " << KernelRegistry::availableNames() << ")" << std::endl;
+            } else if (KernelRegistry::select(name)) {
+                std::cout << "Packed evolve kernel set to " << KernelRegistry::active().name << std::endl;
             } else {
-                std::cout << "Current number of threads: " << omp_get_max_threads() << std::endl;
+                commandFailed = true;
+                std::cout << "Kernel '" << name << "' is not available on this CPU. Available: "
+                          << KernelRegistry::availableNames() << std::endl;
             }
         } else if (command == "set") {
             if (!world) {
+                commandFailed = true;
                 std::cout << "No world exists. Create or load a world first." << std::endl;
                 return true;
             }
             
-            int arg1, arg2, arg3;
+            long long arg1, arg2, arg3;
             if (iss >> arg1 >> arg2 >> arg3) {
                 // 2D coordinates
+                if (arg3 != 0 && arg3 != 1) {
+                    commandFailed = true;
+                    std::cout << "Usage: set <x> <y> <0|1> or set <position> <0|1>" << std::endl;
+                    return true;
+                }
                 world->setCell(arg1, arg2, arg3 != 0);
                 std::cout << "Set cell at (" << arg1 << ", " << arg2 << ") to " << (arg3 != 0 ? "alive" : "dead") << std::endl;
             } else {
                 // Reset stream and try with 1D coordinate
                 iss.clear();
                 iss.seekg(0);
-                iss >> command >> arg1 >> arg2;
-                world->setCell(arg1, arg2 != 0);
+                if (!(iss >> command >> arg1 >> arg2) || (arg2 != 0 && arg2 != 1)) {
+                    commandFailed = true;
+                    std::cout << "Usage: set <x> <y> <0|1> or set <position> <0|1>" << std::endl;
+                    return true;
+                }
+                world->setCell(static_cast<int>(arg1), arg2 != 0);
                 std::cout << "Set cell at position " << arg1 << " to " << (arg2 != 0 ? "alive" : "dead") << std::endl;
             }
         } else if (command == "get") {
             if (!world) {
+                commandFailed = true;
                 std::cout << "No world exists. Create or load a world first." << std::endl;
                 return true;
             }
             
-            int arg1, arg2;
+            long long arg1, arg2;
             if (iss >> arg1 >> arg2) {
                 // 2D coordinates
                 bool state = world->getCell(arg1, arg2);
@@ -467,111 +7670,278 @@ public:
                 iss.clear();
                 iss.seekg(0);
                 iss >> command >> arg1;
-                bool state = world->getCell(arg1);
+                bool state = world->getCell(static_cast<int>(arg1));
                 std::cout << "Cell at position " << arg1 << " is " << (state ? "alive" : "dead") << std::endl;
             }
         } else if (command == "glider") {
             if (!world) {
+                commandFailed = true;
                 std::cout << "No world exists. Create or load a world first." << std::endl;
                 return true;
             }
             
-            int x, y;
+            long long x = 0, y = 0;
             iss >> x >> y;
             world->addGlider(x, y);
             std::cout << "Added glider at (" << x << ", " << y << ")" << std::endl;
         } else if (command == "toad") {
             if (!world) {
+                commandFailed = true;
                 std::cout << "No world exists. Create or load a world first." << std::endl;
                 return true;
             }
             
-            int x, y;
+            long long x = 0, y = 0;
             iss >> x >> y;
             world->addToad(x, y);
             std::cout << "Added toad at (" << x << ", " << y << ")" << std::endl;
         } else if (command == "beacon") {
             if (!world) {
+                commandFailed = true;
                 std::cout << "No world exists. Create or load a world first." << std::endl;
                 return true;
             }
             
-            int x, y;
+            long long x = 0, y = 0;
             iss >> x >> y;
             world->addBeacon(x, y);
             std::cout << "Added beacon at (" << x << ", " << y << ")" << std::endl;
         } else if (command == "methuselah") {
             if (!world) {
+                commandFailed = true;
                 std::cout << "No world exists. Create or load a world first." << std::endl;
                 return true;
             }
             
-            int x, y;
+            long long x = 0, y = 0;
             iss >> x >> y;
             world->addMethuselah(x, y);
             std::cout << "Added methuselah at (" << x << ", " << y << ")" << std::endl;
-        } else if (command == "random") {
+        } else if (command == "random" || command == "fill") {
+            if (!world) {
+                commandFailed = true;
+                std::cout << "No world exists. Create or load a world first." << std::endl;
+                return true;
+            }
+
+            // Without an explicit seed, draw one and report it so the world can be rebuilt
+            double amount = 0;
+            unsigned long long seed = 0;
+            iss >> amount;
+            if (!(iss >> seed)) {
+                std::random_device rd;
+                seed = (static_cast<unsigned long long>(rd()) << 32) | rd();
+            }
+            if (command == "random") {
+                long long count = static_cast<long long>(amount);
+                if (count <= 0) {
+                    commandFailed = true;
+                    std::cout << "Please provide a positive number of patterns." << std::endl;
+                    return true;
+                }
+                world->addRandomPatterns(count, seed);
+                std::cout << "Added " << count << " random patterns (seed " << seed << ")" << std::endl;
+            } else {
+                if (!(amount >= 0 && amount <= 1)) {
+                    commandFailed = true;
+                    std::cout << "Please provide a density between 0 and 1." << std::endl;
+                    return true;
+                }
+                auto start = std::chrono::high_resolution_clock::now();
+                world->fillRandom(amount, seed);
+                std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+                std::cout << "Filled " << static_cast<uint64_t>(world->getWidth()) * world->getHeight()
+                          << " cells at density " << amount << " in " << elapsed.count() << " ms (seed "
+                          << seed << ")" << std::endl;
+            }
+        } else if (command == "stats") {
             if (!world) {
+                commandFailed = true;
                 std::cout << "No world exists. Create or load a world first." << std::endl;
                 return true;
             }
             
-            int count;
-            iss >> count;
-            if (count > 0) {
-                world->addRandomPatterns(count);
-                std::cout << "Added " << count << " random patterns" << std::endl;
+            std::cout << "Generation: " << world->getGeneration() << std::endl;
+            std::cout << "Storage: " << GameOfLife::storageName(world->getStorage()) << std::endl;
+            std::cout << "Population: " << world->getPopulation() << std::endl;
+            if (world->getStorage() == GameOfLife::Storage::Tiled) {
+                std::cout << "Active tiles: " << world->getActiveTiles() << " of " << world->getTileCount()
+                          << " (64x64 cells each)" << std::endl;
+            } else if (world->getStorage() == GameOfLife::Storage::Sparse) {
+                std::cout << "Allocated chunks: " << world->getChunkCount() << " (64x64 cells each)" << std::endl;
+            }
+#ifdef GOL_PROFILING
+            Profiler::instance().print(std::cout);
+#endif
+        } else if (command == "profile") {
+#ifdef GOL_PROFILING
+            std::string mode, arg;
+            iss >> mode >> arg;
+            Profiler& profiler = Profiler::instance();
+            if (mode == "on" || mode == "off") {
+                profiler.setEnabled(mode == "on");
+                std::cout << "Profiling " << (mode == "on" ? "enabled" : "disabled") << std::endl;
+            } else if (mode == "hw" && (arg == "on" || arg == "off")) {
+                if (profiler.setHardware(arg == "on")) {
+                    std::cout << "Hardware counters " << (arg == "on" ? "opened for " + std::to_string(omp_get_max_threads()) + " threads" : "closed") << std::endl;
+                } else {
+                    commandFailed = true;
+                    std::cout << "Hardware counters are not available (perf_event_open failed; see "
+                              << "/proc/sys/kernel/perf_event_paranoid)" << std::endl;
+                }
+            } else if (mode == "json" && !arg.empty()) {
+                profilePath = (arg == "off") ? "" : arg;
+                std::cout << (profilePath.empty() ? "No profile will be written" : "Profile JSON will be written to " + profilePath + " after each run") << std::endl;
+            } else if (mode.empty()) {
+                std::cout << "Profiling is " << (profiler.isEnabled() ? "on" : "off") << ", hardware counters "
+                          << (profiler.hasHardware() ? "on" : "off") << std::endl;
+                profiler.print(std::cout);
             } else {
-                std::cout << "Please provide a positive number of patterns." << std::endl;
+                commandFailed = true;
+                std::cout << "Usage: profile [on|off], profile hw <on|off>, profile json <file|off>" << std::endl;
             }
+#else
+            std::cout << "This build has no instrumentation; configure with -DGOL_PROFILING=ON." << std::endl;
+#endif
         } else if (command == "help") {
             printHelp();
         } else {
+            commandFailed = true;
             std::cout << "Unknown command. Type 'help' for a list of commands." << std::endl;
+            unknownCommand = command;
         }
         
         return true;
     }
 
     // Run the simulation for a specified number of generations
-    void runSimulation(int generations) {
+    // Parse the optional "block <k>" suffix of run/benchmark. Reports (and
+    // returns false for) invalid values and explains when blocking is unused.
+    bool parseBlockOption(std::istringstream& iss, int& block) {
+        std::string option;
+        if (!(iss >> option)) return true;
+        if (option != "block" || !(iss >> block) || block <= 0) {
+            commandFailed = true;
+            std::cout << "Usage: <n> [block <k>] with a positive k." << std::endl;
+            return false;
+        }
+        if (block > 1 && !world->supportsTemporalBlocking()) {
+            std::cout << "Temporal blocking needs packed storage and 'stability 0'; "
+                      << "advancing one generation per pass." << std::endl;
+        }
+        return true;
+    }
+
+    // Show the world before evolving generation 'index' of 'total'
+    void showGeneration(int index, int total) {
+        // Frames over the frame rate limit are dropped, the last one never is
+        if (index == total || renderer.frameDue()) {
+            std::string status = "Generation " + std::to_string(index) + " of " + std::to_string(total) +
+                                 " (Threads: " + std::to_string(omp_get_max_threads()) + ")";
+            if (renderer.getZoom() != 1 || renderer.getViewX() != 0 || renderer.getViewY() != 0) {
+                status += " view " + std::to_string(renderer.getViewX()) + "," + std::to_string(renderer.getViewY()) +
+                          " zoom " + std::to_string(renderer.getZoom());
+            }
+            GOL_PROFILE_SCOPE(Render);
+            renderer.publish(*world, status);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(delayTime));
+    }
+
+    void runSimulation(int generations, int block = 1) {
         if (!world) return;
         
         // Start time measurement
         auto start = std::chrono::high_resolution_clock::now();
+#ifdef GOL_PROFILING
+        Profiler::instance().begin();
+#endif
         
         // Enter alternate screen mode for cleaner visualization
         if (printEnabled) {
-            std::cout << "\033[?1049h";
+            renderer.begin();
         }
         
+        // Generations advanced per step; the stability check needs every generation,
+        // and a recording needs every generation
+        int step = (world->supportsTemporalBlocking() && !recorder.isOpen()) ? block : 1;
         bool isStable = false;
-        for (int i = 0; i < generations && !isStable; i++) {
-            if (printEnabled) {
-                // Clear screen and move cursor to top-left
-                std::cout << "\033[2J\033[H";
-                std::cout << "Generation " << i + 1 << " of " << generations << " (Threads: " << omp_get_max_threads() << ")" << std::endl;
-                world->print();
-                std::this_thread::sleep_for(std::chrono::milliseconds(delayTime));
+        int stableAfter = 0;
+        // Measured generations are gathered while they are evolved
+        uint64_t metricsInterval = metricsStream.isOpen() ? metricsStream.getInterval() : 0;
+        if (metricsInterval > 0) {
+            world->setMetricsInterval(metricsInterval);
+            metricsStream.beginRun(world->getGeneration());
+        }
+        // A replaced world may start below the generation the next snapshot was due at
+        if (snapshotInterval > 0) {
+            nextSnapshot = std::min(nextSnapshot, world->getGeneration() + snapshotInterval);
+        }
+        if (step > 1) {
+            for (int i = 0; i < generations; ) {
+                if (printEnabled) {
+                    showGeneration(i + 1, generations);
+                }
+                // A step ends at the next measured generation, if one is sooner
+                int steps = std::min(step, generations - i);
+                if (metricsInterval > 0) {
+                    steps = static_cast<int>(std::min<uint64_t>(steps, metricsInterval - world->getGeneration() % metricsInterval));
+                }
+                world->evolveSteps(steps);
+                checkpointStep(steps);
+                snapshotStep(steps);
+                metricsStep();
+                i += steps;
             }
-            
-            world->evolve();
-            
-            // Check stability if enabled
-            if (stabilityCheckEnabled && i >= 2 && world->isStable()) {
-                isStable = true;
-                std::cout << "World has reached a stable state after " << i + 1 << " generations." << std::endl;
+        } else {
+            // One thread team for the whole run; printing and the stability
+            // check happen between generations on one of its threads
+            if (printEnabled) {
+                showGeneration(1, generations);
             }
+            world->runGenerations(generations, [&](int done) {
+                checkpointStep(1);
+                snapshotStep(1);
+                metricsStep();
+                if (recorder.isOpen()) {
+                    GOL_PROFILE_SCOPE(Record);
+                    recorder.append(*world);
+                }
+                // Check stability if enabled
+                if (stabilityCheckEnabled && world->isStable()) {
+                    isStable = true;
+                    stableAfter = done;
+                    return false;
+                }
+                if (printEnabled && done < generations) {
+                    showGeneration(done + 1, generations);
+                }
+                return true;
+            });
         }
         
         // Leave alternate screen mode
         if (printEnabled) {
-            std::cout << "\033[?1049l";
+            renderer.end();
+        }
+        if (metricsInterval > 0) {
+            world->setMetricsInterval(0);
+            metricsStream.endRun();
+        }
+        if (isStable) {
+            std::cout << "World has reached a stable state (period " << world->getCyclePeriod()
+                      << ") after " << stableAfter << " generations." << std::endl;
         }
         
         // End time measurement
         auto end = std::chrono::high_resolution_clock::now();
         std::chrono::duration<double, std::milli> elapsed = end - start;
+#ifdef GOL_PROFILING
+        Profiler::instance().end();
+        if (!profilePath.empty() && Profiler::instance().writeJSON(profilePath)) {
+            std::cout << "Profile written to " << profilePath << std::endl;
+        }
+#endif
         
         std::cout << "Simulation of " << generations << " generations completed in " 
                   << elapsed.count() << " ms (using " << omp_get_max_threads() << " threads)" << std::endl;
@@ -586,15 +7956,70 @@ public:
         std::cout << "Conway's Game of Life - Parallelized Command Line Interface" << std::endl;
         std::cout << "-----------------------------------------------------------" << std::endl;
         std::cout << "Available commands:" << std::endl;
-        std::cout << "  create <width> <height>    - Create a new world with specified dimensions" << std::endl;
-        std::cout << "  load <filename>            - Load a world from a file" << std::endl;
-        std::cout << "  save <filename>            - Save the current world to a file" << std::endl;
+        std::cout << "  create <width> <height> [dense|packed|tiled|sparse]" << std::endl;
+        std::cout << "                             - Create a new world; 'packed' selects the bit-packed backend," << std::endl;
+        std::cout << "                               'tiled' also skips tiles that are not changing," << std::endl;
+        std::cout << "                               'sparse' is unbounded (width x height is the printed view)" << std::endl;
+        std::cout << "  load <filename>            - Load a world from a file (text or binary, auto-detected)" << std::endl;
+        std::cout << "  save <filename> [text|binary|binary-rle]" << std::endl;
+        std::cout << "                             - Save the current world to a file (text by default)" << std::endl;
+        std::cout << "  checkpoint every <n> <path> - Write a binary checkpoint every n generations during runs" << std::endl;
+        std::cout << "                               (in the background); 'checkpoint off' stops, no argument shows status" << std::endl;
+        std::cout << "  record <file> [keyframe <k>] - Record every generation of later runs as deltas, with a" << std::endl;
+        std::cout << "                               keyframe every k frames; 'record off' stops, no argument shows status" << std::endl;
+        std::cout << "  metrics every <n> <file> [csv|json]" << std::endl;
+        std::cout << "                             - Stream population, births, deaths, bounding box, active regions" << std::endl;
+        std::cout << "                               and generation rate of every n-th generation of later runs to a" << std::endl;
+        std::cout << "                               file or pipe; 'metrics off' stops, no argument shows status" << std::endl;
+        std::cout << "  region <x> <y> <w> <h> [file]" << std::endl;
+        std::cout << "                             - Read a region (clipped to a bounded world) as packed rows of 64-bit" << std::endl;
+        std::cout << "                               words, printed or raw to a file; 'region set <x> <y> <w> <h> <file>'" << std::endl;
+        std::cout << "                               writes one back" << std::endl;
+        std::cout << "  snapshot every <n>         - Publish every n-th generation of later runs for reader threads" << std::endl;
+        std::cout << "                               without pausing them; 'snapshot take' publishes the current one," << std::endl;
+        std::cout << "                               'snapshot off' stops, no argument shows status" << std::endl;
+        std::cout << "  snapshot region <x> <y> <w> <h> [file]" << std::endl;
+        std::cout << "                             - Read a region of the newest published snapshot" << std::endl;
+        std::cout << "  snapshot watch <x> <y> <w> <h> <file>" << std::endl;
+        std::cout << "                             - Append the region of each new snapshot to a file from a background" << std::endl;
+        std::cout << "                               thread; 'snapshot watch off' stops" << std::endl;
+        std::cout << "  replay <file> [from [to]]  - Play back recorded generations (sparse recordings hold the view)" << std::endl;
+        std::cout << "  seek <gen>                 - Reconstruct a generation of the last replayed recording" << std::endl;
+        std::cout << "  resume <path>              - Load a checkpoint, restoring its generation and cycle history" << std::endl;
+        std::cout << "  import <file> [x y]        - Place an RLE or macrocell (.mc) pattern with its top-left at (x,y)" << std::endl;
+        std::cout << "  export <file> [rle|mc]     - Write the live area as RLE or macrocell (by extension if omitted)" << std::endl;
         std::cout << "  print <0|1>                - Disable/enable printing the world after each generation" << std::endl;
         std::cout << "  delay <ms>                 - Set the delay time in milliseconds between generations" << std::endl;
+        std::cout << "  render [classic|block|half|braille]" << std::endl;
+        std::cout << "                             - Glyphs for printing (1x1, 1x1, 1x2 or 2x4 cells per character)" << std::endl;
+        std::cout << "  view <x> <y> [zoom]        - Print the world from (x,y), zoom x zoom cells per dot; 'view fit'" << std::endl;
+        std::cout << "                               shows the whole world" << std::endl;
+        std::cout << "  fps [n]                    - Redraw at most n times per second while running (0 = every generation)" << std::endl;
         std::cout << "  stability <0|1>            - Disable/enable stability check" << std::endl;
-        std::cout << "  run <n>                    - Run the simulation for n generations" << std::endl;
-        std::cout << "  benchmark <n>              - Run benchmark for n generations (no visualization)" << std::endl;
-        std::cout << "  threads <n>                - Set number of OpenMP threads (or show current)" << std::endl;
+        std::cout << "  period [n]                 - Detect cycles up to period n in the stability check" << std::endl;
+        std::cout << "  run <n> [block <k>]        - Run the simulation for n generations" << std::endl;
+        std::cout << "  benchmark <n> [block <k>]  - Run benchmark for n generations (no visualization)" << std::endl;
+        std::cout << "                               'block k' advances k generations per memory pass" << std::endl;
+        std::cout << "                               (packed storage with the stability check off)" << std::endl;
+        std::cout << "  jump <n>                   - Advance n generations at once with HashLife" << std::endl;
+        std::cout << "                               (square power-of-two worlds, others step normally)" << std::endl;
+        std::cout << "  ensemble <n> <w> <h> [density [seed]]" << std::endl;
+        std::cout << "                             - Create n w x h packed worlds, world i filled with seed + i" << std::endl;
+        std::cout << "  ensemble run <n>           - Evolve every ensemble world up to n generations; a world stops" << std::endl;
+        std::cout << "                               when it becomes stable (unless 'stability 0')" << std::endl;
+        std::cout << "  ensemble stats             - Show ensemble generations, population and cycle periods" << std::endl;
+        std::cout << "  ensemble pick <i>          - Make ensemble world i the current world" << std::endl;
+        std::cout << "  distributed fill <w> <h> <density> <seed> <n> [file]" << std::endl;
+        std::cout << "  distributed load <file> <n> [file]" << std::endl;
+        std::cout << "                             - Run n generations of a world split into row strips over the" << std::endl;
+        std::cout << "                               MPI ranks (mpirun -np 4 game_of_life --distributed ...)," << std::endl;
+        std::cout << "                               each rank reading and writing only its own rows" << std::endl;
+        std::cout << "  hashmem [MB]               - Set the HashLife node cache limit (or show usage)" << std::endl;
+        std::cout << "  threads <n> [pin|nopin]    - Set number of OpenMP threads (or show current), optionally" << std::endl;
+        std::cout << "                               pinning each thread to its own CPU" << std::endl;
+        std::cout << "  kernel [name|auto]         - Force the packed evolve kernel (or show current)" << std::endl;
+        std::cout << "  rule [B/S[/C]|name]        - Set the rule (or show current), e.g. B36/S23, or B2/S/C3 for a" << std::endl;
+        std::cout << "                               Generations rule with dying states (dense storage only)" << std::endl;
         std::cout << "  set <x> <y> <0|1>          - Set cell at (x,y) dead or alive" << std::endl;
         std::cout << "  set <pos> <0|1>            - Set cell at position pos dead or alive" << std::endl;
         std::cout << "  get <x> <y>                - Get state of cell at (x,y)" << std::endl;
@@ -603,15 +8028,139 @@ public:
         std::cout << "  toad <x> <y>               - Add a toad pattern at (x,y)" << std::endl;
         std::cout << "  beacon <x> <y>             - Add a beacon pattern at (x,y)" << std::endl;
         std::cout << "  methuselah <x> <y>         - Add a methuselah pattern at (x,y)" << std::endl;
-        std::cout << "  random <n>                 - Add n random patterns to the world" << std::endl;
+        std::cout << "  random <n> [seed]          - Add n random patterns to the world (same seed, same world)" << std::endl;
+        std::cout << "  fill <density> [seed]      - Replace the world with a uniform random fill" << std::endl;
+        std::cout << "  stats                      - Show generation, population, tile and chunk statistics and the" << std::endl;
+        std::cout << "                               profile of the last run" << std::endl;
+        std::cout << "  profile [on|off]           - Enable/disable the run profile (phase times, thread balance, allocations)" << std::endl;
+        std::cout << "  profile hw <on|off>        - Count cycles, instructions and cache misses (Linux perf events)" << std::endl;
+        std::cout << "  profile json <file|off>    - Write the profile as JSON after each run or benchmark" << std::endl;
         std::cout << "  help                       - Display this help information" << std::endl;
         std::cout << "  exit/quit                  - Exit the program" << std::endl;
+        std::cout << "Every command also runs non-interactively as a program argument, e.g." << std::endl;
+        std::cout << "  game_of_life --load world.bin --threads 8 --run 1000 --save out.bin binary" << std::endl;
+        std::cout << "  game_of_life --script edits.txt [--verbose]   (one command per line, replies hidden)" << std::endl;
+    }
+
+    // Fast path for "set <x> <y> <0|1>" lines of a script: parsed in place
+    // and applied without a reply. Returns false for anything else (which
+    // goes through processCommand and its error reporting).
+    bool scriptSet(const std::string& line) {
+        if (!world || line.compare(0, 4, "set ") != 0) return false;
+        const char* p = line.c_str() + 4;
+        char* end;
+        long long values[3];
+        for (long long& value : values) {
+            value = std::strtoll(p, &end, 10);
+            if (end == p) return false;
+            p = end;
+        }
+        while (*p == ' ' || *p == '\t' || *p == '\r') p++;
+        if (*p || (values[2] != 0 && values[2] != 1)) return false;
+        world->setCell(values[0], values[1], values[2] != 0);
+        return true;
+    }
+
+    // Run the commands of a script file, one per line ('#' starts a comment).
+    // Replies are dropped unless verbose; errors on std::cerr still show.
+    // Stops at the first unknown or failed command and returns false then,
+    // or if the file cannot be read.
+    bool runScript(const std::string& filename, BatchOutput& output, bool verbose, bool& running) {
+        std::ifstream file(filename, std::ios::binary);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not open script " << filename << std::endl;
+            return false;
+        }
+        std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        output.setDiscard(!verbose);
+        size_t lineNumber = 0;
+        bool ok = true;
+        for (size_t pos = 0; pos < text.size() && running && ok;) {
+            size_t next = text.find('\n', pos);
+            if (next == std::string::npos) next = text.size();
+            std::string line = text.substr(pos, next - pos);
+            pos = next + 1;
+            lineNumber++;
+            size_t first = line.find_first_not_of(" \t\r");
+            if (first == std::string::npos || line[first] == '#') continue;
+            if (first > 0) line.erase(0, first);
+            if (scriptSet(line)) continue;
+            running = processCommand(line);
+            if (!unknownCommand.empty()) {
+                output.flush();
+                std::cerr << filename << ":" << lineNumber << ": unknown command '" << unknownCommand << "'" << std::endl;
+                ok = false;
+            } else if (commandFailed) {
+                output.flush();
+                std::cerr << filename << ":" << lineNumber << ": command failed: " << line << std::endl;
+                ok = false;
+            }
+        }
+        output.setDiscard(false);
+        return ok;
+    }
+
+    // Non-interactive mode: each "--name [args...]" program argument is the
+    // command "name args..." (e.g. --load world.bin --threads 32 --run 1000
+    // --save out.bin), run in order. --no-print is "print 0", --script <file>
+    // runs a command file and --verbose shows the replies of script commands.
+    // Printing starts disabled. Stops at the first failed command;
+    // returns the process exit code (1 for a failed command, 2 for an unknown one).
+    int runArguments(int argc, char** argv) {
+        BatchOutput output(std::cout.rdbuf());
+        std::streambuf* original = std::cout.rdbuf(&output);
+        printEnabled = false;
+
+        // Group the arguments into commands
+        std::vector<std::string> commands;
+        bool verbose = false;
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg.compare(0, 2, "--") != 0 || arg.size() == 2) {
+                if (commands.empty()) {
+                    std::cerr << "Error: expected an option, got '" << arg << "'" << std::endl;
+                    std::cout.rdbuf(original);
+                    return 2;
+                }
+                commands.back() += " " + arg;
+            } else if (arg == "--verbose") {
+                verbose = true;
+            } else if (arg == "--no-print") {
+                commands.push_back("print 0");
+            } else {
+                commands.push_back(arg.substr(2));
+            }
+        }
+
+        int status = 0;
+        bool running = true;
+        for (size_t i = 0; i < commands.size() && running && status == 0; i++) {
+            const std::string& command = commands[i];
+            if (command.compare(0, 7, "script ") == 0) {
+                if (!runScript(command.substr(7), output, verbose, running)) status = 1;
+                continue;
+            }
+            running = processCommand(command);
+            if (!unknownCommand.empty()) {
+                output.flush();
+                std::cerr << "Error: unknown option --" << unknownCommand << std::endl;
+                status = 2;
+            } else if (commandFailed) {
+                output.flush();
+                std::cerr << "Error: --" << command << " failed" << std::endl;
+                status = 1;
+            }
+        }
+        output.flush();
+        std::cout.rdbuf(original);
+        return status;
     }
 
     // Main loop for command processing
     void run() {
         std::cout << "Conway's Game of Life (OpenMP Parallelized)" << std::endl;
         std::cout << "Available threads: " << omp_get_max_threads() << std::endl;
+        std::cout << "Packed evolve kernel: " << KernelRegistry::active().name << std::endl;
         std::cout << "Type 'help' for a list of commands." << std::endl;
         
         std::string input;
@@ -627,9 +8176,372 @@ public:
     }
 };
 
+// BenchSuite - reproducible benchmark harness (the game_of_life_bench target).
+// Every case builds its world from a fixed seed, so two runs (or two
+// commits) evolve exactly the same cells. Cases are the cross product of
+// sizes, storages, densities, workloads, thread counts and kernels; each is
+// warmed up, then timed generation by generation. Results go to stdout as a
+// table, or as JSON / CSV for regression tracking.
+class BenchSuite {
+public:
+    struct Options {
+        std::vector<int> sizes{ 128, 1024, 8192 };   // Square world sides
+        std::vector<std::string> storages{ "packed", "tiled", "sparse", "dense" };
+        std::vector<double> densities{ 0.35 };
+        std::vector<std::string> workloads{ "random" }; // random (uniform fill) or soup (seeded patterns)
+        std::vector<int> threads;                     // Empty: the OpenMP default only
+        std::vector<std::string> kernels{ "auto" };   // Packed/tiled kernels, "all" for every supported one
+        LifeRule rule;
+        uint64_t seed = 1;
+        int generations = 0;                          // 0: as many as fit in minTime
+        double minTime = 0.5;                         // Seconds per case when generations is 0
+        int64_t maxDenseCells = int64_t(1) << 26;     // Larger dense cases are skipped (vector<bool> is slow)
+        std::string format = "text";                  // text, json or csv
+        std::string output;                           // Empty: stdout
+        bool help = false;                            // --help: print the usage and exit
+    };
+
+    struct Result {
+        int size = 0;
+        std::string storage;
+        double density = 0;
+        std::string workload;
+        int threads = 0;
+        std::string kernel;
+        int generations = 0;
+        double seconds = 0;
+        double cellsPerSecond = 0;
+        double bytesPerSecond = 0; // Estimated grid traffic (one read and one write of every stored cell)
+        double p50 = 0, p90 = 0, p99 = 0, minMs = 0, maxMs = 0; // Per-generation time (ms)
+        uint64_t population = 0;   // Live cells after the run, identical across kernels and threads
+    };
+
+    // Build the world of one case from the seed
+    static std::unique_ptr<GameOfLife> buildWorld(const Options& options, int size, GameOfLife::Storage storage,
+                                                  double density, const std::string& workload) {
+        std::unique_ptr<GameOfLife> world(new GameOfLife(size, size, storage));
+        world->setRule(options.rule);
+        world->setCycleDetection(false);
+        if (workload == "soup") {
+            // One pattern per 1 / density * 64 cells
+            world->addRandomPatterns(static_cast<int64_t>(static_cast<double>(size) * size * density / 64), options.seed);
+        } else {
+            world->fillRandom(density, options.seed);
+        }
+        return world;
+    }
+
+    // Bytes a generation reads and writes, one bit per stored cell
+    static double generationBytes(const GameOfLife& world) {
+        double cellBytes = 2.0 / 8.0;
+        switch (world.getStorage()) {
+            case GameOfLife::Storage::Tiled:
+                return cellBytes * world.getActiveTiles() * 64.0 * 64.0;
+            case GameOfLife::Storage::Sparse:
+                return cellBytes * static_cast<double>(world.getChunkCount()) * SparseGrid::chunkSize * 64.0;
+            default:
+                return cellBytes * world.getWidth() * world.getHeight();
+        }
+    }
+
+    static double percentile(std::vector<double> values, double p) {
+        if (values.empty()) return 0;
+        size_t k = static_cast<size_t>(p * static_cast<double>(values.size() - 1) + 0.5);
+        std::nth_element(values.begin(), values.begin() + k, values.end());
+        return values[k];
+    }
+
+    // Run one case on a freshly built world
+    static Result runCase(const Options& options, int size, const std::string& storageName, double density,
+                          const std::string& workload, int threads, const std::string& kernel) {
+        GameOfLife::Storage storage = GameOfLife::Storage::Dense;
+        GameOfLife::parseStorage(storageName, storage);
+        omp_set_num_threads(threads);
+        std::unique_ptr<GameOfLife> world = buildWorld(options, size, storage, density, workload);
+
+        // Warm-up: first touch of the other ring slots, and the per-generation
+        // time used to size the run
+        auto start = std::chrono::steady_clock::now();
+        world->runGenerations(2, nullptr);
+        double warmup = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / 2;
+        int generations = options.generations;
+        if (generations <= 0) {
+            generations = static_cast<int>(std::min(10000.0, std::max(5.0, options.minTime / std::max(warmup, 1e-9))));
+        }
+
+        std::vector<double> times;
+        times.reserve(generations);
+        double bytes = 0;
+        auto last = std::chrono::steady_clock::now();
+        start = last;
+        world->runGenerations(generations, [&](int) {
+            auto now = std::chrono::steady_clock::now();
+            times.push_back(std::chrono::duration<double, std::milli>(now - last).count());
+            bytes += generationBytes(*world);
+            last = now;
+            return true;
+        });
+        double seconds = std::chrono::duration<double>(last - start).count();
+
+        Result result;
+        result.size = size;
+        result.storage = storageName;
+        result.density = density;
+        result.workload = workload;
+        result.threads = threads;
+        result.kernel = kernel;
+        result.generations = generations;
+        result.seconds = seconds;
+        result.cellsPerSecond = static_cast<double>(size) * size * generations / seconds;
+        result.bytesPerSecond = bytes / seconds;
+        result.p50 = percentile(times, 0.50);
+        result.p90 = percentile(times, 0.90);
+        result.p99 = percentile(times, 0.99);
+        result.minMs = *std::min_element(times.begin(), times.end());
+        result.maxMs = *std::max_element(times.begin(), times.end());
+        result.population = world->getPopulation();
+        return result;
+    }
+
+    static void writeText(std::ostream& out, const std::vector<Result>& results) {
+        char line[256];
+        std::snprintf(line, sizeof(line), "%-8s %-7s %-6s %-7s %4s %-7s %6s %12s %8s %9s %9s %9s %12s\n",
+                      "size", "storage", "dens", "load", "thr", "kernel", "gens", "Mcells/s", "GB/s",
+                      "p50 ms", "p90 ms", "p99 ms", "population");
+        out << line;
+        for (const Result& r : results) {
+            std::snprintf(line, sizeof(line), "%-8d %-7s %-6.3f %-7s %4d %-7s %6d %12.1f %8.2f %9.3f %9.3f %9.3f %12llu\n",
+                          r.size, r.storage.c_str(), r.density, r.workload.c_str(), r.threads, r.kernel.c_str(),
+                          r.generations, r.cellsPerSecond / 1e6, r.bytesPerSecond / 1e9, r.p50, r.p90, r.p99,
+                          static_cast<unsigned long long>(r.population));
+            out << line;
+        }
+    }
+
+    static void writeCSV(std::ostream& out, const std::vector<Result>& results) {
+        out << "size,storage,density,workload,threads,kernel,generations,seconds,cells_per_second,"
+               "bytes_per_second,p50_ms,p90_ms,p99_ms,min_ms,max_ms,population\n";
+        for (const Result& r : results) {
+            out << r.size << ',' << r.storage << ',' << r.density << ',' << r.workload << ',' << r.threads << ','
+                << r.kernel << ',' << r.generations << ',' << r.seconds << ',' << r.cellsPerSecond << ','
+                << r.bytesPerSecond << ',' << r.p50 << ',' << r.p90 << ',' << r.p99 << ',' << r.minMs << ','
+                << r.maxMs << ',' << r.population << '\n';
+        }
+    }
+
+    static void writeJSON(std::ostream& out, const Options& options, const std::vector<Result>& results) {
+        out << "{\n  \"suite\": \"game_of_life_bench\",\n  \"seed\": " << options.seed
+            << ",\n  \"rule\": \"" << options.rule.toString() << "\",\n  \"max_threads\": " << omp_get_num_procs()
+            << ",\n  \"kernels\": \"" << KernelRegistry::availableNames() << "\",\n  \"results\": [";
+        for (size_t i = 0; i < results.size(); i++) {
+            const Result& r = results[i];
+            out << (i ? "," : "") << "\n    {\"size\": " << r.size << ", \"storage\": \"" << r.storage
+                << "\", \"density\": " << r.density << ", \"workload\": \"" << r.workload
+                << "\", \"threads\": " << r.threads << ", \"kernel\": \"" << r.kernel
+                << "\", \"generations\": " << r.generations << ", \"seconds\": " << r.seconds
+                << ", \"cells_per_second\": " << r.cellsPerSecond << ", \"bytes_per_second\": " << r.bytesPerSecond
+                << ", \"p50_ms\": " << r.p50 << ", \"p90_ms\": " << r.p90 << ", \"p99_ms\": " << r.p99
+                << ", \"min_ms\": " << r.minMs << ", \"max_ms\": " << r.maxMs
+                << ", \"population\": " << r.population << "}";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+    // Split a comma or space separated list
+    static std::vector<std::string> splitList(std::string list) {
+        std::replace(list.begin(), list.end(), ',', ' ');
+        std::istringstream ss(list);
+        std::vector<std::string> items;
+        std::string item;
+        while (ss >> item) items.push_back(item);
+        return items;
+    }
+
+    static void printUsage() {
+        std::cout << "Usage: game_of_life_bench [options]" << std::endl;
+        std::cout << "  --sizes <n,...>        Square world sides (default 128,1024,8192; e.g. 65536 for GB-sized worlds)" << std::endl;
+        std::cout << "  --storage <s,...>      dense, packed, tiled, sparse (default all)" << std::endl;
+        std::cout << "  --density <d,...>      Live cell fraction of the workload (default 0.35)" << std::endl;
+        std::cout << "  --workload <w,...>     random (uniform fill) or soup (seeded patterns)" << std::endl;
+        std::cout << "  --threads <n,...>      Thread counts to sweep (default: OpenMP default)" << std::endl;
+        std::cout << "  --kernels <k,...>      Packed kernels to sweep, or 'all' (default auto)" << std::endl;
+        std::cout << "  --rule <rule>          Rule to evolve (default B3/S23)" << std::endl;
+        std::cout << "  --seed <n>             Workload seed (default 1)" << std::endl;
+        std::cout << "  --gens <n>             Generations per case (default: fill --min-time)" << std::endl;
+        std::cout << "  --min-time <s>         Seconds per case when --gens is not given (default 0.5)" << std::endl;
+        std::cout << "  --max-dense <cells>    Skip dense cases larger than this (default 2^26)" << std::endl;
+        std::cout << "  --format <f>           text, json or csv (default text)" << std::endl;
+        std::cout << "  --output <file>        Write results to a file instead of stdout" << std::endl;
+    }
+
+    // Parse the command line; returns false (after printing why) on bad input
+    static bool parseOptions(int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--help" || arg == "-h") {
+                printUsage();
+                options.help = true;
+                return true;
+            }
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " needs a value" << std::endl;
+                return false;
+            }
+            std::string value = argv[++i];
+            std::vector<std::string> items = splitList(value);
+            try {
+                if (arg == "--sizes") {
+                    options.sizes.clear();
+                    for (const std::string& item : items) options.sizes.push_back(std::stoi(item));
+                } else if (arg == "--storage") {
+                    options.storages = items;
+                } else if (arg == "--density") {
+                    options.densities.clear();
+                    for (const std::string& item : items) options.densities.push_back(std::stod(item));
+                } else if (arg == "--workload") {
+                    options.workloads = items;
+                } else if (arg == "--threads") {
+                    options.threads.clear();
+                    for (const std::string& item : items) options.threads.push_back(std::stoi(item));
+                } else if (arg == "--kernels") {
+                    options.kernels = (value == "all") ? splitList(KernelRegistry::availableNames()) : items;
+                } else if (arg == "--rule") {
+                    if (!LifeRule::parse(value, options.rule) || options.rule.isGenerations()) {
+                        std::cerr << "Error: invalid or Generations rule '" << value << "'" << std::endl;
+                        return false;
+                    }
+                } else if (arg == "--seed") {
+                    options.seed = std::stoull(value);
+                } else if (arg == "--gens") {
+                    options.generations = std::stoi(value);
+                } else if (arg == "--min-time") {
+                    options.minTime = std::stod(value);
+                } else if (arg == "--max-dense") {
+                    options.maxDenseCells = std::stoll(value);
+                } else if (arg == "--format") {
+                    options.format = value;
+                } else if (arg == "--output") {
+                    options.output = value;
+                } else {
+                    std::cerr << "Error: unknown option " << arg << std::endl;
+                    return false;
+                }
+            } catch (const std::exception&) {
+                std::cerr << "Error: invalid value '" << value << "' for " << arg << std::endl;
+                return false;
+            }
+        }
+        for (int size : options.sizes) {
+            if (size <= 0) {
+                std::cerr << "Error: world sizes must be positive, got " << size << std::endl;
+                return false;
+            }
+        }
+        for (double density : options.densities) {
+            if (density < 0 || density > 1) {
+                std::cerr << "Error: densities must be between 0 and 1, got " << density << std::endl;
+                return false;
+            }
+        }
+        for (int threads : options.threads) {
+            if (threads <= 0) {
+                std::cerr << "Error: thread counts must be positive, got " << threads << std::endl;
+                return false;
+            }
+        }
+        for (const std::string& storage : options.storages) {
+            GameOfLife::Storage parsed;
+            if (!GameOfLife::parseStorage(storage, parsed)) {
+                std::cerr << "Error: unknown storage '" << storage << "'" << std::endl;
+                return false;
+            }
+        }
+        for (const std::string& workload : options.workloads) {
+            if (workload != "random" && workload != "soup") {
+                std::cerr << "Error: unknown workload '" << workload << "'" << std::endl;
+                return false;
+            }
+        }
+        if (options.format != "text" && options.format != "json" && options.format != "csv") {
+            std::cerr << "Error: unknown format '" << options.format << "'" << std::endl;
+            return false;
+        }
+        if (options.threads.empty()) options.threads.push_back(omp_get_max_threads());
+        return true;
+    }
+
+    // Entry point of the benchmark executable
+    static int main(int argc, char** argv) {
+        Options options;
+        if (!parseOptions(argc, argv, options)) return 2;
+        if (options.help) return 0;
+
+        std::vector<Result> results;
+        for (int size : options.sizes) {
+            for (const std::string& storage : options.storages) {
+                if (storage == "dense" && static_cast<int64_t>(size) * size > options.maxDenseCells) {
+                    std::cerr << "Skipping dense " << size << "x" << size << " (over --max-dense)" << std::endl;
+                    continue;
+                }
+                // Only packed rows go through the selectable kernels
+                bool kernelSweep = (storage == "packed" || storage == "tiled");
+                std::vector<std::string> kernels = kernelSweep ? options.kernels : std::vector<std::string>{ "auto" };
+                for (double density : options.densities) {
+                    for (const std::string& workload : options.workloads) {
+                        for (int threads : options.threads) {
+                            for (const std::string& kernel : kernels) {
+                                if (!KernelRegistry::select(kernel)) {
+                                    std::cerr << "Skipping kernel " << kernel << " (not available)" << std::endl;
+                                    continue;
+                                }
+                                std::string kernelName = kernelSweep ? KernelRegistry::active().name : "-";
+                                std::cerr << "Running " << size << "x" << size << " " << storage << " " << workload
+                                          << " " << density << " threads " << threads << " kernel " << kernelName
+                                          << "..." << std::endl;
+                                results.push_back(runCase(options, size, storage, density, workload, threads, kernelName));
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        KernelRegistry::select("auto");
+
+        std::ofstream file;
+        if (!options.output.empty()) {
+            file.open(options.output);
+            if (!file.is_open()) {
+                std::cerr << "Error: Could not open file " << options.output << std::endl;
+                return 1;
+            }
+        }
+        std::ostream& out = options.output.empty() ? std::cout : file;
+        if (options.format == "json") {
+            writeJSON(out, options, results);
+        } else if (options.format == "csv") {
+            writeCSV(out, results);
+        } else {
+            writeText(out, results);
+        }
+        return out.good() ? 0 : 1;
+    }
+};
+
 // Main function to create the command line interface
-int main() {
+int main(int argc, char** argv) {
+#ifdef GOL_BENCH_MAIN
+    return BenchSuite::main(argc, argv);
+#else
     CommandLine cli;
-    cli.run();
-    return 0;
+    int status = 0;
+    if (argc > 1) {
+        status = cli.runArguments(argc, argv);
+    } else {
+        cli.run();
+    }
+#ifdef GOL_MPI
+    DistributedWorld::finalize();
+#endif
+    return status;
+#endif
 }
\ No newline at end of file